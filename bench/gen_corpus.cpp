@@ -0,0 +1,162 @@
+/*
+    Generates a synthetic fortran corpus for benchmarking ftc.
+
+    gen_corpus [-modules N] [-procs M] [-calls K] [-depth D] [-extent S] [-o DIR]
+
+    writes DIR/mod<i>.f90 for i in [0,N), each a module of M subroutines, and DIR/main.f90.
+    module i uses module i-1; every subroutine makes K calls to subroutines of the same or
+    previous module, and has a DO/IF nest D deep (counters i1..iD) over a rank 3 local array
+    of extent S indexed by the first three.
+    DIR/files.txt lists the sources in dependency order, as ftc should be given them.
+*/
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+#include <sys/stat.h>
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::ofstream;
+using std::stringstream;
+
+struct Params {
+    int modules;
+    int procs;
+    int calls;
+    int depth;
+    int extent;
+    string dir;
+};
+
+string proc_name(int module, int proc) {
+    stringstream ret;
+    ret << "m" << module << "_p" << proc;
+    return ret.str();
+}
+
+string indent(int level) {
+    return string(4*level, ' ');
+}
+
+//DO/IF nest of the given depth around updates of 'work' and 'a'.
+void gen_nest(ofstream& out, const Params& p, int level, int depth) {
+    if(depth==0) {
+        out << indent(level) << "work(i1,i2,i3) = work(i1,i2,i3) + a(i1) * s - 2.d0\n";
+        out << indent(level) << "a(i1) = a(i1) + work(i1,i2,i3) * 0.5d0\n";
+        return;
+    }
+
+    //a counter per level, as a nested loop can't redefine an enclosing one's.
+    int var = p.depth-depth + 1;
+    out << indent(level) << "do i" << var << " = 1, n\n";
+    out << indent(level+1) << "if (i" << var << " > " << depth << ") then\n";
+    gen_nest(out, p, level+2, depth-1);
+    out << indent(level+1) << "else\n";
+    out << indent(level+2) << "s = s + " << depth << ".d0\n";
+    out << indent(level+1) << "end if\n";
+    out << indent(level) << "end do\n";
+}
+
+void gen_module(const Params& p, int module) {
+    stringstream path;
+    path << p.dir << "/mod" << module << ".f90";
+    ofstream out (path.str().c_str());
+
+    out << "module mod" << module << "\n";
+    if(module!=0) out << "use mod" << module-1 << "\n";
+    out << "contains\n\n";
+
+    for(int proc = 0; proc<p.procs; proc++) {
+        out << "subroutine " << proc_name(module,proc) << "(a, n, s)\n";
+        out << "    integer(4), intent(in) :: n\n";
+        out << "    real(8), dimension(" << p.extent << ") :: a\n";
+        out << "    real(8) :: s\n";
+        out << "    real(8), dimension(" << p.extent << "," << p.extent << "," << p.extent << ") :: work\n";
+        int counters = std::max(p.depth, 3);
+        out << "    integer(4) ::";
+        for(int i = 1; i<=counters; i++)
+            out << (i==1 ? " " : ", ") << "i" << i;
+        out << "\n\n";
+        for(int i = 1; i<=counters; i++)
+            out << "    i" << i << " = 1\n";
+
+        gen_nest(out, p, 1, p.depth);
+
+        //calls to earlier procedures of this module, or to the previous module.
+        for(int call = 0; call<p.calls; call++) {
+            int cmodule = module;
+            int cproc = proc==0 ? -1 : (call*7 + proc) % proc;
+            if(cproc<0) {
+                if(module==0) break;
+                cmodule = module-1;
+                cproc = (call*7) % p.procs;
+            }
+            out << "    call " << proc_name(cmodule,cproc) << "(a, n - " << call%3 << ", s)\n";
+        }
+
+        out << "end subroutine " << proc_name(module,proc) << "\n\n";
+    }
+
+    out << "end module mod" << module << "\n";
+}
+
+void gen_main(const Params& p) {
+    ofstream out ((p.dir + "/main.f90").c_str());
+    out << "integer(4) function main()\n";
+    if(p.modules>0) out << "    use mod" << p.modules-1 << "\n";
+    out << "    real(8), dimension(" << p.extent << ") :: a\n";
+    out << "    real(8) :: s\n\n";
+    out << "    s = 1.d0\n";
+    if(p.modules>0 && p.procs>0)
+        out << "    call " << proc_name(p.modules-1, p.procs-1) << "(a, " << p.extent << ", s)\n";
+    out << "    print *, s\n";
+    out << "    main = 0\n";
+    out << "    return\n";
+    out << "end\n";
+}
+
+int main(int argc, char* argv[]) {
+    Params p;
+    p.modules = 8;
+    p.procs = 16;
+    p.calls = 32;
+    p.depth = 4;
+    p.extent = 64;
+    p.dir = "corpus";
+
+    for(int i = 1; i<argc; i++) {
+        string arg = argv[i];
+        if(i+1==argc) {
+            cout << "missing value for " << arg << endl;
+            return 1;
+        }
+        string value = argv[++i];
+
+        if     (arg=="-modules") p.modules = atoi(value.c_str());
+        else if(arg=="-procs")   p.procs   = atoi(value.c_str());
+        else if(arg=="-calls")   p.calls   = atoi(value.c_str());
+        else if(arg=="-depth")   p.depth   = atoi(value.c_str());
+        else if(arg=="-extent")  p.extent  = atoi(value.c_str());
+        else if(arg=="-o")       p.dir     = value;
+        else {
+            cout << "unknown option " << arg << endl;
+            return 1;
+        }
+    }
+
+    mkdir(p.dir.c_str(), 0755);
+
+    ofstream files ((p.dir + "/files.txt").c_str());
+    for(int module = 0; module<p.modules; module++) {
+        gen_module(p, module);
+        files << "mod" << module << ".f90 ";
+    }
+    gen_main(p);
+    files << "main.f90" << endl;
+
+    return 0;
+}
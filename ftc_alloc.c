@@ -0,0 +1,124 @@
+#include "ftc_alloc.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define FTC__ALIGN 64
+
+/* classes: 0 for up to 64 bytes, then 4 per power of two up to 2^(FTC__MAX_LOG+1). */
+#define FTC__MAX_LOG 40
+#define FTC__CLASSES (1 + 4*(FTC__MAX_LOG-5))
+
+/* sits in the FTC__ALIGN bytes before every block handed out. */
+typedef struct block {
+    size_t size;         /* bytes usable */
+    size_t used;         /* bytes asked for */
+    int cls;
+    struct block* next;  /* on a free list */
+} block;
+
+static block* ftc__free_lists[FTC__CLASSES];
+static volatile int ftc__lock = 0;
+
+static struct {
+    long allocs, reused, frees;
+    size_t live, peak;     /* bytes asked for */
+    size_t held, held_peak; /* bytes from the system, including free lists */
+} ftc__stats;
+
+static int ftc__reporting = -1;
+
+static void ftc__report(void) {
+    fprintf(stderr, "ftc alloc: %ld allocations (%ld reused), %ld frees; peak %.1f KB allocated, %.1f KB from the system\n",
+        ftc__stats.allocs, ftc__stats.reused, ftc__stats.frees,
+        ftc__stats.peak/1024.0, ftc__stats.held_peak/1024.0);
+}
+
+/* size class of an allocation, and the size of its blocks. -1 if too big to keep. */
+static int ftc__class(size_t bytes, size_t* size) {
+    int k = 6;
+    size_t step, j;
+    
+    if(bytes<=64) {
+        *size = 64;
+        return 0;
+    }
+    
+    /* 2^k < bytes <= 2^(k+1) */
+    while(k<FTC__MAX_LOG && ((size_t)1<<(k+1))<bytes) k++;
+    if(((size_t)1<<(k+1))<bytes) {
+        *size = (bytes + FTC__ALIGN-1) & ~(size_t)(FTC__ALIGN-1);
+        return -1;
+    }
+    
+    step = (size_t)1<<(k-2);
+    j = (bytes - ((size_t)1<<k) + step-1)/step;
+    *size = ((size_t)1<<k) + j*step;
+    return 1 + (k-6)*4 + (int)(j-1);
+}
+
+void* ftc__alloc(size_t bytes) {
+    size_t size;
+    int cls = ftc__class(bytes, &size);
+    block* b = NULL;
+    
+    while(__sync_lock_test_and_set(&ftc__lock, 1));
+    
+    if(ftc__reporting<0) {
+        const char* env = getenv("FTC_ALLOC_REPORT");
+        ftc__reporting = env!=NULL && env[0]!='\0' && !(env[0]=='0' && env[1]=='\0');
+        if(ftc__reporting) atexit(ftc__report);
+    }
+    
+    if(cls>=0 && ftc__free_lists[cls]!=NULL) {
+        b = ftc__free_lists[cls];
+        ftc__free_lists[cls] = b->next;
+        ftc__stats.reused++;
+    }
+    
+    if(b==NULL) {
+        void* raw = NULL;
+        if(posix_memalign(&raw, FTC__ALIGN, FTC__ALIGN + size)!=0) {
+            __sync_lock_release(&ftc__lock);
+            fprintf(stderr, "ftc: out of memory allocating %lu bytes\n", (unsigned long)bytes);
+            exit(1);
+        }
+        b = (block*)raw;
+        b->size = size;
+        b->cls = cls;
+        
+        ftc__stats.held += FTC__ALIGN + size;
+        if(ftc__stats.held>ftc__stats.held_peak) ftc__stats.held_peak = ftc__stats.held;
+    }
+    
+    b->used = bytes;
+    b->next = NULL;
+    
+    ftc__stats.allocs++;
+    ftc__stats.live += bytes;
+    if(ftc__stats.live>ftc__stats.peak) ftc__stats.peak = ftc__stats.live;
+    
+    __sync_lock_release(&ftc__lock);
+    return (char*)b + FTC__ALIGN;
+}
+
+void ftc__free(void* p) {
+    block* b;
+    if(p==NULL) return;
+    
+    b = (block*)((char*)p - FTC__ALIGN);
+    
+    while(__sync_lock_test_and_set(&ftc__lock, 1));
+    
+    ftc__stats.frees++;
+    ftc__stats.live -= b->used;
+    
+    if(b->cls>=0) {
+        b->next = ftc__free_lists[b->cls];
+        ftc__free_lists[b->cls] = b;
+    }else {
+        ftc__stats.held -= FTC__ALIGN + b->size;
+        free(b);
+    }
+    
+    __sync_lock_release(&ftc__lock);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stddef.h>
+
+/**
+
+    Allocator for FORTRAN ALLOCATE/DEALLOCATE.
+    
+    real(8), allocatable, dimension(:,:) :: w
+    allocate (w(n,m))
+    deallocate (w)
+    
+    becomes
+    
+    double* w = 0;
+    ...
+    w = (double*)ftc__alloc(sizeof(double)*n*m);
+    ftc__free(w);
+    
+    memory is 64 byte aligned. freed blocks are kept on free lists by size class (4 classes
+    to every power of two) and handed out again to allocations of the same class, so arrays
+    allocated and freed every timestep don't go back to malloc.
+    
+    ftc__alloc never returns NULL; it exits when out of memory. ftc__free(NULL) does nothing.
+    
+    with the environment variable FTC_ALLOC_REPORT set (and not "0"), counts of allocations,
+    reuses and frees and the peak bytes allocated are printed to stderr at exit.
+    
+**/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void* ftc__alloc(size_t bytes);
+void ftc__free(void* p);
+
+#ifdef __cplusplus
+}
+#endif
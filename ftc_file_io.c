@@ -1,47 +1,912 @@
+#include "ftc_file_io.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-typedef struct file_id {
-    FILE* file;
+/*
+    unit table. units 0..FTC__DIRECT-1 are found by indexing ftc__direct, any other unit
+    through a small open addressed hash table, so ftc__get_file is constant time whatever
+    the unit number. a unit keeps its record once opened, so closing and reopening it costs
+    no allocation; records are handed out from a preallocated pool, each starting on its own
+    cache line so no two units share one.
+*/
+
+#define FTC__DIRECT 128
+#define FTC__POOL   64
+
+/* size of a unit's read buffer; grown if a single value doesn't fit. */
+#define FTC__RBUF (1<<18)
+
+typedef struct ftc__unit {
+    FILE* file;    /* NULL when closed */
+    int id;
+
+    /* list-directed input: unread input is buf[pos,len). */
+    char* buf;
+    size_t pos, len, cap;
+    int eof;
+    int mapped;    /* buf is a mapping of the whole (read only) file; spare the read buffer */
+    char* spare;
+    size_t spare_cap;
+    int pending;   /* a value was just read; a comma following it is its separator */
+    int slash;     /* a '/' ended the current READ */
+    int rep_null;  /* the repeated value is null */
+    long repeat;   /* copies of an r*c value still to be read */
+    char* rep;     /* the repeated value c */
+    size_t rep_len, rep_cap;
+
+    /* unformatted input/output. */
+    int unformatted;
+    int stream;    /* no record markers */
+    size_t sub_left;   /* bytes left in the current subrecord */
+    size_t sub_len;    /* length of the current subrecord */
+    size_t rec_left;   /* bytes of the record after the current subrecord (writing) */
+    int more;          /* another subrecord follows (reading) */
+    int continued;     /* the current subrecord continues the record (writing) */
+
+    /* list-directed output: the record being written, obuf[0,olen). */
+    char* obuf;
+    size_t olen, ocap;
+} __attribute__((aligned(64))) ftc__unit;
+
+static ftc__unit* ftc__direct[FTC__DIRECT];
+
+/* hash of the other units: capacity a power of two, kept at most half full. */
+typedef struct ftc__slot {
     int id;
-    struct file_id* next;
-} file_id;
+    ftc__unit* unit; /* NULL for an empty slot */
+} ftc__slot;
+
+static ftc__slot* ftc__hash = NULL;
+static size_t ftc__hash_cap = 0;
+static size_t ftc__hash_used = 0;
+
+/* records not yet bound to a unit. */
+static ftc__unit ftc__pool[FTC__POOL];
+static ftc__unit* ftc__pool_next = ftc__pool;
+static size_t ftc__pool_left = FTC__POOL;
+
+static size_t ftc__hash_of(int id) {
+    unsigned int h = (unsigned int)id * 2654435761u;
+    return h ^ (h >> 16);
+}
+
+static ftc__unit* ftc__find(int id) {
+    size_t i;
+
+    if((unsigned int)id < FTC__DIRECT) return ftc__direct[id];
+    if(ftc__hash_cap==0) return NULL;
+
+    for(i = ftc__hash_of(id) & (ftc__hash_cap-1); ftc__hash[i].unit!=NULL; i = (i+1) & (ftc__hash_cap-1))
+        if(ftc__hash[i].id==id) return ftc__hash[i].unit;
+    return NULL;
+}
+
+static void ftc__hash_insert(ftc__slot* table, size_t cap, int id, ftc__unit* unit) {
+    size_t i = ftc__hash_of(id) & (cap-1);
+    while(table[i].unit!=NULL) i = (i+1) & (cap-1);
+    table[i].id = id;
+    table[i].unit = unit;
+}
+
+static ftc__unit* ftc__new_unit(int id) {
+    ftc__unit* unit;
+
+    if(ftc__pool_left==0) {
+        /* calloc only guarantees 16 byte alignment; records are 64 byte aligned. */
+        void* pool;
+        if(posix_memalign(&pool, 64, FTC__POOL*sizeof(ftc__unit))!=0) {
+            fprintf(stderr, "ftc: out of memory opening unit %d\n", id);
+            exit(1);
+        }
+        ftc__pool_next = (ftc__unit*)pool;
+        ftc__pool_left = FTC__POOL;
+    }
+    unit = ftc__pool_next++;
+    ftc__pool_left--;
+
+    memset(unit, 0, sizeof(ftc__unit));
+    unit->id = id;
+    return unit;
+}
+
+/* record of a unit, bound to it on first use. */
+static ftc__unit* ftc__bind(int id) {
+    ftc__unit* unit = ftc__find(id);
+    if(unit!=NULL) return unit;
+
+    unit = ftc__new_unit(id);
+    if((unsigned int)id < FTC__DIRECT) {
+        ftc__direct[id] = unit;
+        return unit;
+    }
 
-file_id* ftc__files = NULL;
+    if(2*(ftc__hash_used+1) > ftc__hash_cap) {
+        size_t cap = ftc__hash_cap==0 ? 16 : 2*ftc__hash_cap;
+        size_t i;
+        ftc__slot* table = (ftc__slot*)calloc(cap, sizeof(ftc__slot));
+        if(table==NULL) {
+            fprintf(stderr, "ftc: out of memory opening unit %d\n", id);
+            exit(1);
+        }
+        for(i = 0; i<ftc__hash_cap; i++)
+            if(ftc__hash[i].unit!=NULL)
+                ftc__hash_insert(table, cap, ftc__hash[i].id, ftc__hash[i].unit);
+
+        free(ftc__hash);
+        ftc__hash = table;
+        ftc__hash_cap = cap;
+    }
+    ftc__hash_insert(ftc__hash, ftc__hash_cap, id, unit);
+    ftc__hash_used++;
+    return unit;
+}
+
+/* record of an open unit, connecting the preconnected units on first use. NULL if not open. */
+static ftc__unit* ftc__open_unit(int id) {
+    ftc__unit* unit = ftc__find(id);
+    if(unit==NULL && (id==5 || id==6)) {
+        unit = ftc__bind(id);
+        unit->file = id==5 ? stdin : stdout;
+    }
+    return unit==NULL || unit->file==NULL ? NULL : unit;
+}
 
 FILE* ftc__get_file(int id) {
-    file_id* cf = ftc__files;
-    while(cf!=NULL && cf->id != id) cf = cf->next;
-        
-    if(cf!=NULL) return cf->file;
-    else return NULL;
+    ftc__unit* unit = ftc__open_unit(id);
+    return unit==NULL ? NULL : unit->file;
 }
 
-void ftc__open_file(int id, const char* path) {
-    file_id* cf = ftc__files;
-    while(cf!=NULL && cf->id != id) cf = cf->next;
-    
-    if(cf!=NULL) {
-        fclose(cf->file);
-        cf->file = fopen(path,"rw");
-    }else {
-        cf = (file_id*)malloc(sizeof(file_id));
-        cf->file = fopen(path,"rw");
-        cf->id = id;
-        cf->next = ftc__files;
-        ftc__files = cf;
+/*
+    a unit opened read only on a regular file is read from a mapping of it: buf is the whole
+    file, parsed in place, and unformatted reads are copies out of it. pipes, terminals and
+    files that can't be mapped are read through the read buffer.
+*/
+static void ftc__map(ftc__unit* unit) {
+    struct stat st;
+    void* map;
+    int fd = fileno(unit->file);
+
+    if(fstat(fd, &st)!=0 || !S_ISREG(st.st_mode) || st.st_size==0) return;
+
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(map==MAP_FAILED) return;
+    madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    unit->spare = unit->buf;
+    unit->spare_cap = unit->cap;
+    unit->buf = (char*)map;
+    unit->pos = 0;
+    unit->len = unit->cap = (size_t)st.st_size;
+    unit->eof = 1;
+    unit->mapped = 1;
+}
+
+static void ftc__unmap(ftc__unit* unit) {
+    if(!unit->mapped) return;
+
+    munmap(unit->buf, unit->cap);
+    unit->buf = unit->spare;
+    unit->cap = unit->spare_cap;
+    unit->mapped = 0;
+}
+
+/* back to the start of a (re)connected unit, keeping its buffers. */
+static void ftc__reset(ftc__unit* unit) {
+    ftc__unmap(unit);
+    unit->pos = unit->len = 0;
+    unit->eof = 0;
+    unit->pending = unit->slash = 0;
+    unit->repeat = 0;
+    unit->sub_left = unit->rec_left = 0;
+    unit->more = unit->continued = 0;
+    unit->olen = 0;
+}
+
+static void ftc__unit_error(int id, const char* what) {
+    fprintf(stderr, "ftc: %s on unit %d\n", what, id);
+    exit(2);
+}
+
+/* an OPEN specifier's value, ignoring case and trailing blanks. */
+static int ftc__is(const char* spec, const char* value) {
+    size_t n = strlen(spec);
+    while(n>0 && spec[n-1]==' ') n--;
+    if(n!=strlen(value)) return 0;
+    for(; n>0; n--, spec++, value++)
+        if(tolower((unsigned char)*spec)!=*value) return 0;
+    return 1;
+}
+
+void ftc__open(int id, const char* path, const char* status, const char* access,
+               const char* form, const char* action, const char* position) {
+    ftc__unit* unit = ftc__bind(id);
+    char name[4096];
+    int flags = 0, fd = -1;
+    size_t n;
+
+    if(unit->file!=NULL) fclose(unit->file);
+    unit->file = NULL;
+    ftc__reset(unit);
+
+    if(access!=NULL && ftc__is(access, "direct"))
+        ftc__unit_error(id, "ACCESS='DIRECT' is not supported");
+    if(access!=NULL && !ftc__is(access, "sequential") && !ftc__is(access, "stream"))
+        ftc__unit_error(id, "bad ACCESS in OPEN");
+    unit->stream = access!=NULL && ftc__is(access, "stream");
+
+    /* stream files are unformatted unless said otherwise */
+    if(form==NULL)
+        unit->unformatted = unit->stream;
+    else if(ftc__is(form, "unformatted") || ftc__is(form, "formatted"))
+        unit->unformatted = ftc__is(form, "unformatted");
+    else
+        ftc__unit_error(id, "bad FORM in OPEN");
+
+    if(status!=NULL && ftc__is(status, "scratch")) {
+        unit->file = tmpfile();
+        if(unit->file==NULL) ftc__unit_error(id, strerror(errno));
+        return;
+    }
+    if(path==NULL) ftc__unit_error(id, "no FILE in OPEN");
+
+    /* fortran strings may be blank padded */
+    n = strlen(path);
+    while(n>0 && path[n-1]==' ') n--;
+    if(n>=sizeof(name)) ftc__unit_error(id, "FILE name too long in OPEN");
+    memcpy(name, path, n);
+    name[n] = '\0';
+
+    if(status==NULL || ftc__is(status, "unknown")) flags = O_CREAT;
+    else if(ftc__is(status, "new"))     flags = O_CREAT | O_EXCL;
+    else if(ftc__is(status, "replace")) flags = O_CREAT | O_TRUNC;
+    else if(!ftc__is(status, "old"))    ftc__unit_error(id, "bad STATUS in OPEN");
+
+    /* without an ACTION, as gfortran: read and write if allowed, else whichever is */
+    if(action==NULL) {
+        fd = open(name, flags | O_RDWR, 0666);
+        if(fd<0 && (errno==EACCES || errno==EROFS || errno==EISDIR)) {
+            fd = open(name, (flags & ~(O_CREAT | O_TRUNC)) | O_RDONLY);
+            if(fd<0) fd = open(name, flags | O_WRONLY, 0666);
+        }
+    }
+    else if(ftc__is(action, "read"))      fd = open(name, (flags & ~(O_CREAT | O_TRUNC)) | O_RDONLY);
+    else if(ftc__is(action, "write"))     fd = open(name, flags | O_WRONLY, 0666);
+    else if(ftc__is(action, "readwrite")) fd = open(name, flags | O_RDWR, 0666);
+    else ftc__unit_error(id, "bad ACTION in OPEN");
+
+    if(fd<0) {
+        fprintf(stderr, "ftc: can't open '%s' on unit %d: %s\n", name, id, strerror(errno));
+        exit(2);
     }
+
+    switch(fcntl(fd, F_GETFL) & O_ACCMODE) {
+        case O_RDONLY: unit->file = fdopen(fd, "r");  break;
+        case O_WRONLY: unit->file = fdopen(fd, "w");  break;
+        default:       unit->file = fdopen(fd, "r+"); break;
+    }
+    if(unit->file==NULL) ftc__unit_error(id, strerror(errno));
+
+    if((fcntl(fd, F_GETFL) & O_ACCMODE)==O_RDONLY) ftc__map(unit);
+
+    if(position!=NULL && ftc__is(position, "append"))
+        fseeko(unit->file, 0, SEEK_END);
+    else if(position!=NULL && !ftc__is(position, "asis") && !ftc__is(position, "rewind"))
+        ftc__unit_error(id, "bad POSITION in OPEN");
+}
+
+void ftc__open_file(int id, const char* path) {
+    ftc__open(id, path, NULL, NULL, NULL, NULL, NULL);
 }
 
 void ftc__close_file(int id) {
-    file_id* cf = ftc__files;
-    file_id* pre = NULL;
-    while(cf!=NULL && cf->id != id) { pre = cf; cf = cf->next; }
-    if(cf!=NULL) {
-        if(pre==NULL) ftc__files = cf->next;
-        else pre->next = cf->next;
-        
-        fclose(cf->file);
-        free(cf);
+    ftc__unit* unit = ftc__find(id);
+    if(unit!=NULL && unit->file!=NULL) {
+        ftc__unmap(unit);
+        fclose(unit->file);
+        unit->file = NULL;
+    }
+}
+
+/*
+    list-directed input
+*/
+
+static void ftc__read_error(int id, const char* what) {
+    fprintf(stderr, "ftc: %s reading unit %d\n", what, id);
+    exit(2);
+}
+
+static ftc__unit* ftc__read_unit(int id) {
+    ftc__unit* unit = ftc__open_unit(id);
+    if(unit==NULL) ftc__read_error(id, "unit not open");
+    if(unit->unformatted) ftc__read_error(id, "list-directed input on an unformatted unit");
+    return unit;
+}
+
+/* more input after buf[pos,len), moved to the front of the buffer. 0 at end of file. */
+static int ftc__fill(ftc__unit* unit) {
+    ssize_t n;
+
+    if(unit->eof) return 0;
+
+    if(unit->pos>0) {
+        memmove(unit->buf, unit->buf + unit->pos, unit->len - unit->pos);
+        unit->len -= unit->pos;
+        unit->pos = 0;
+    }
+    if(unit->len==unit->cap) {
+        size_t cap = unit->cap==0 ? FTC__RBUF : 2*unit->cap;
+        char* buf = (char*)realloc(unit->buf, cap);
+        if(buf==NULL) ftc__read_error(unit->id, "out of memory");
+        unit->buf = buf;
+        unit->cap = cap;
+    }
+
+    do n = read(fileno(unit->file), unit->buf + unit->len, unit->cap - unit->len);
+    while(n<0 && errno==EINTR);
+
+    if(n<=0) {
+        if(n<0) ftc__read_error(unit->id, strerror(errno));
+        unit->eof = 1;
+        return 0;
+    }
+    unit->len += n;
+    return 1;
+}
+
+static int ftc__is_blank(char c) {
+    return c==' ' || c=='\n' || c=='\t' || c=='\r';
+}
+
+static int ftc__is_separator(char c) {
+    return ftc__is_blank(c) || c==',' || c=='/';
+}
+
+/* length of the value at pos, read in whole: up to a separator, or a closing quote. */
+static size_t ftc__extent(ftc__unit* unit) {
+    char quote = unit->buf[unit->pos];
+    size_t i = unit->pos + 1;
+    int more;
+
+    if(quote!='\'' && quote!='"') quote = 0;
+
+    for(;;) {
+        if(quote==0) {
+            while(i<unit->len && !ftc__is_separator(unit->buf[i])) i++;
+            if(i<unit->len) return i - unit->pos;
+        }else {
+            /* a doubled quote stands for one */
+            while(i<unit->len) {
+                if(unit->buf[i]!=quote) i++;
+                else if(i+1==unit->len) break; /* can't tell yet if it's doubled */
+                else if(unit->buf[i+1]==quote) i += 2;
+                else return i+1 - unit->pos;
+            }
+        }
+
+        i -= unit->pos;
+        more = ftc__fill(unit);
+        i += unit->pos;
+
+        if(!more) {
+            if(quote==0) return unit->len - unit->pos;
+            if(i<unit->len && unit->buf[i]==quote) return i+1 - unit->pos;
+            ftc__read_error(unit->id, "unterminated string");
+        }
+    }
+}
+
+/*
+    moves to the next value of the current READ. 0 for a null value; otherwise 1, with the
+    value's text in [*text, *text + *n), valid until the unit is next read.
+*/
+static int ftc__value(ftc__unit* unit, const char** text, size_t* n) {
+    const char* value;
+    size_t len, j;
+    long r = 0;
+    int c;
+
+    if(unit->repeat>0) {
+        unit->repeat--;
+        if(unit->rep_null) return 0;
+        *text = unit->rep;
+        *n = unit->rep_len;
+        return 1;
+    }
+    if(unit->slash) return 0;
+
+    /* blanks and ends of records, and the comma ending the last value */
+    do {
+        const char* p = unit->buf + unit->pos;
+        const char* e = unit->buf + unit->len;
+        for(; p<e; p++) {
+            if(*p==',' && unit->pending) unit->pending = 0;
+            else if(!ftc__is_blank(*p)) break;
+        }
+        unit->pos = p - unit->buf;
+    }while(unit->pos==unit->len && ftc__fill(unit));
+    c = unit->pos<unit->len ? (unsigned char)unit->buf[unit->pos] : -1;
+
+    if(c<0) ftc__read_error(unit->id, "end of file");
+    if(c==',') {
+        unit->pos++;
+        return 0;
+    }
+    if(c=='/') {
+        unit->pos++;
+        unit->slash = 1;
+        return 0;
+    }
+
+    len = ftc__extent(unit);
+    value = unit->buf + unit->pos;
+    unit->pos += len;
+    unit->pending = 1;
+
+    /* r*c */
+    for(j = 0; j<len && value[j]>='0' && value[j]<='9'; j++)
+        r = r<LONG_MAX/10 ? 10*r + (value[j]-'0') : LONG_MAX;
+    if(j>0 && j<len && value[j]=='*') {
+        if(r==0) ftc__read_error(unit->id, "zero repeat count");
+        unit->repeat = r-1;
+        unit->rep_null = j+1==len;
+        if(unit->rep_null) return 0;
+
+        len -= j+1;
+        if(len>unit->rep_cap) {
+            char* rep = (char*)realloc(unit->rep, len);
+            if(rep==NULL) ftc__read_error(unit->id, "out of memory");
+            unit->rep = rep;
+            unit->rep_cap = len;
+        }
+        memcpy(unit->rep, value + j+1, len);
+        unit->rep_len = len;
+        value = unit->rep;
+    }
+
+    *text = value;
+    *n = len;
+    return 1;
+}
+
+static long ftc__parse_integer(int id, const char* s, size_t n, long min, long max) {
+    const char* e = s + n;
+    unsigned long value = 0;
+    int neg = 0;
+
+    if(s<e && (*s=='+' || *s=='-')) neg = *s++=='-';
+    if(s==e) ftc__read_error(id, "bad integer");
+
+    for(; s<e; s++) {
+        unsigned int d = (unsigned int)(*s - '0');
+        if(d>9) ftc__read_error(id, "bad integer");
+        if(value > ((unsigned long)LONG_MAX + 1)/10) ftc__read_error(id, "integer overflow");
+        value = 10*value + d;
+    }
+
+    if(neg ? value > (unsigned long)-(min+1) + 1 : value > (unsigned long)max)
+        ftc__read_error(id, "integer overflow");
+    return neg ? (long)(0 - value) : (long)value;
+}
+
+static const double ftc__pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/*
+    a real: [sign] digits [. digits] [exponent], the exponent letter e, d or q, or left out
+    before a signed exponent. values with at most 15 (7 for single) significant digits and a
+    small exponent are exact as m * 10^e or m / 10^-e, one correctly rounded operation; any
+    other value (and inf/nan) goes to strtod.
+*/
+static double ftc__parse_real(int id, const char* s, size_t n, int single) {
+    const char* p = s;
+    const char* e = s + n;
+    const char* q;
+    unsigned long m = 0;
+    unsigned int d;
+    int digits, any = 0, neg = 0;
+    long exp10 = 0;
+
+    if(p<e && (*p=='+' || *p=='-')) neg = *p++=='-';
+
+    /* leading zeros aren't significant; m is only used with at most 15 digits */
+    for(; p<e && *p=='0'; p++) any = 1;
+    for(q = p; p<e && (d = (unsigned int)(*p - '0'))<10; p++) m = 10*m + d;
+    digits = (int)(p - q);
+
+    if(p<e && *p=='.') {
+        p++;
+        if(digits==0)
+            for(; p<e && *p=='0'; p++) { exp10--; any = 1; }
+        for(q = p; p<e && (d = (unsigned int)(*p - '0'))<10; p++) m = 10*m + d;
+        digits += (int)(p - q);
+        exp10 -= p - q;
+    }
+    if(digits>0) any = 1;
+
+    if(any && p<e) {
+        long x = 0;
+        int xneg = 0;
+        if(*p=='e' || *p=='E' || *p=='d' || *p=='D' || *p=='q' || *p=='Q') p++;
+        if(p<e && (*p=='+' || *p=='-')) xneg = *p++=='-';
+        if(p==e) any = 0;
+        for(; p<e && *p>='0' && *p<='9'; p++)
+            if(x<100000) x = 10*x + (*p - '0');
+        exp10 += xneg ? -x : x;
+    }
+
+    if(any && p==e && digits<=(single ? 7 : 15) && exp10>=-22 && exp10<=22) {
+        if(single) {
+            float v = (float)m;
+            if(exp10>=-10 && exp10<=10) {
+                v = exp10<0 ? v/(float)ftc__pow10[-exp10] : v*(float)ftc__pow10[exp10];
+                return neg ? -v : v;
+            }
+        }else {
+            double v = exp10<0 ? (double)m/ftc__pow10[-exp10] : (double)m*ftc__pow10[exp10];
+            return neg ? -v : v;
+        }
+    }
+
+    {
+        char copy[128];
+        char* end;
+        double v;
+        size_t i;
+
+        if(n>=sizeof(copy)) ftc__read_error(id, "bad real");
+        for(i = 0; i<n; i++) {
+            char c = s[i];
+            copy[i] = c=='d' || c=='D' || c=='q' || c=='Q' ? 'e' : c;
+        }
+        copy[n] = '\0';
+
+        v = single ? strtof(copy, &end) : strtod(copy, &end);
+        if(n==0 || *end!='\0') ftc__read_error(id, "bad real");
+        return v;
+    }
+}
+
+void ftc__read_int(int id, int* value) {
+    const char* text;
+    size_t n;
+    if(ftc__value(ftc__read_unit(id), &text, &n))
+        *value = (int)ftc__parse_integer(id, text, n, INT_MIN, INT_MAX);
+}
+
+void ftc__read_long(int id, long* value) {
+    const char* text;
+    size_t n;
+    if(ftc__value(ftc__read_unit(id), &text, &n))
+        *value = ftc__parse_integer(id, text, n, LONG_MIN, LONG_MAX);
+}
+
+void ftc__read_float(int id, float* value) {
+    const char* text;
+    size_t n;
+    if(ftc__value(ftc__read_unit(id), &text, &n))
+        *value = (float)ftc__parse_real(id, text, n, 1);
+}
+
+void ftc__read_double(int id, double* value) {
+    const char* text;
+    size_t n;
+    if(ftc__value(ftc__read_unit(id), &text, &n))
+        *value = ftc__parse_real(id, text, n, 0);
+}
+
+/* n values, stride elements apart: the implied DO (a(i), i=1,n) or an array section. */
+#define FTC__READ_VECTOR(NAME, T, PARSE) \
+void NAME(int id, T* values, long n, long stride) { \
+    ftc__unit* unit = ftc__read_unit(id); \
+    const char* text; \
+    size_t len; \
+    long k; \
+    for(k = 0; k<n; k++, values += stride) \
+        if(ftc__value(unit, &text, &len)) \
+            *values = (T)(PARSE); \
+}
+
+FTC__READ_VECTOR(ftc__read_ints,    int,    ftc__parse_integer(id, text, len, INT_MIN, INT_MAX))
+FTC__READ_VECTOR(ftc__read_longs,   long,   ftc__parse_integer(id, text, len, LONG_MIN, LONG_MAX))
+FTC__READ_VECTOR(ftc__read_floats,  float,  ftc__parse_real(id, text, len, 1))
+FTC__READ_VECTOR(ftc__read_doubles, double, ftc__parse_real(id, text, len, 0))
+
+#undef FTC__READ_VECTOR
+
+void ftc__read_string(int id, char* value, long len) {
+    const char* text;
+    size_t n, i;
+    long k = 0;
+
+    if(!ftc__value(ftc__read_unit(id), &text, &n)) return;
+
+    if(n>=2 && (text[0]=='\'' || text[0]=='"')) {
+        /* quoted: a doubled quote stands for one */
+        char quote = text[0];
+        for(i = 1; i+1<n && (len<0 || k<len); i++) {
+            value[k++] = text[i];
+            if(text[i]==quote) i++;
+        }
+    }else
+        for(i = 0; i<n && (len<0 || k<len); i++) value[k++] = text[i];
+
+    if(len<0) value[k] = '\0';
+    else while(k<len) value[k++] = ' ';
+}
+
+void ftc__read_end(int id) {
+    ftc__unit* unit = ftc__read_unit(id);
+    unit->pending = unit->slash = 0;
+    unit->repeat = 0;
+
+    for(;;) {
+        char* nl;
+        if(unit->pos==unit->len && !ftc__fill(unit)) return;
+
+        nl = (char*)memchr(unit->buf + unit->pos, '\n', unit->len - unit->pos);
+        if(nl!=NULL) {
+            unit->pos = nl - unit->buf + 1;
+            return;
+        }
+        unit->pos = unit->len;
+    }
+}
+
+/*
+    list-directed output. a record is built up in the unit's output buffer and handed to
+    stdio in one piece by ftc__write_end. numbers are written as printf's %d and %f, each
+    after a blank unless it starts the record, so that output can be read back as
+    list-directed input.
+*/
+
+static ftc__unit* ftc__write_unit(int id) {
+    ftc__unit* unit = ftc__open_unit(id);
+    if(unit==NULL) ftc__unit_error(id, "unit not open");
+    if(unit->unformatted) ftc__unit_error(id, "list-directed output on an unformatted unit");
+    return unit;
+}
+
+/* room for n more chars in the record. */
+static char* ftc__reserve(ftc__unit* unit, size_t n) {
+    if(unit->olen + n > unit->ocap) {
+        size_t cap = unit->ocap==0 ? 4096 : unit->ocap;
+        char* obuf;
+        while(cap < unit->olen + n) cap *= 2;
+
+        obuf = (char*)realloc(unit->obuf, cap);
+        if(obuf==NULL) ftc__unit_error(unit->id, "out of memory writing");
+        unit->obuf = obuf;
+        unit->ocap = cap;
+    }
+    return unit->obuf + unit->olen;
+}
+
+static void ftc__put_long(ftc__unit* unit, long value) {
+    char digits[24];
+    char* p = ftc__reserve(unit, sizeof(digits) + 1);
+    unsigned long v = value<0 ? 0 - (unsigned long)value : (unsigned long)value;
+    int n = 0;
+
+    if(unit->olen>0) *p++ = ' ';
+    if(value<0) *p++ = '-';
+    do {
+        digits[n++] = (char)('0' + v%10);
+        v /= 10;
+    }while(v!=0);
+    while(n>0) *p++ = digits[--n];
+
+    unit->olen = p - unit->obuf;
+}
+
+static void ftc__put_double(ftc__unit* unit, double value) {
+    /* %f of the largest double: 309 digits, a point and 6 more */
+    char* p = ftc__reserve(unit, 320);
+    if(unit->olen>0) *p++ = ' ';
+    p += snprintf(p, 318, "%f", value);
+    unit->olen = p - unit->obuf;
+}
+
+void ftc__write_int(int id, int value)       { ftc__put_long  (ftc__write_unit(id), value); }
+void ftc__write_long(int id, long value)     { ftc__put_long  (ftc__write_unit(id), value); }
+void ftc__write_float(int id, float value)   { ftc__put_double(ftc__write_unit(id), value); }
+void ftc__write_double(int id, double value) { ftc__put_double(ftc__write_unit(id), value); }
+
+void ftc__write_string(int id, const char* value, long len) {
+    ftc__unit* unit = ftc__write_unit(id);
+    size_t n = len<0 ? strlen(value) : (size_t)len;
+    memcpy(ftc__reserve(unit, n), value, n);
+    unit->olen += n;
+}
+
+#define FTC__WRITE_VECTOR(NAME, T, PUT) \
+void NAME(int id, const T* values, long n, long stride) { \
+    ftc__unit* unit = ftc__write_unit(id); \
+    long k; \
+    for(k = 0; k<n; k++, values += stride) \
+        PUT(unit, *values); \
+}
+
+FTC__WRITE_VECTOR(ftc__write_ints,    int,    ftc__put_long)
+FTC__WRITE_VECTOR(ftc__write_longs,   long,   ftc__put_long)
+FTC__WRITE_VECTOR(ftc__write_floats,  float,  ftc__put_double)
+FTC__WRITE_VECTOR(ftc__write_doubles, double, ftc__put_double)
+
+#undef FTC__WRITE_VECTOR
+
+void ftc__write_end(int id) {
+    ftc__unit* unit = ftc__write_unit(id);
+    *ftc__reserve(unit, 1) = '\n';
+    unit->olen++;
+
+    if(fwrite(unit->obuf, 1, unit->olen, unit->file)!=unit->olen)
+        ftc__unit_error(id, strerror(errno));
+    unit->olen = 0;
+}
+
+/*
+    unformatted input/output. a sequential record is laid out as gfortran does: its length as
+    a 4 byte integer before and after it. records longer than FTC__SUBRECORD are split into
+    subrecords, the leading length of each but the last negated, as is the trailing length of
+    each but the first. a stream file is just the bytes.
+*/
+
+#define FTC__SUBRECORD ((size_t)2147483639)
+
+static ftc__unit* ftc__unformatted_unit(int id) {
+    ftc__unit* unit = ftc__open_unit(id);
+    if(unit==NULL) ftc__unit_error(id, "unit not open");
+    if(!unit->unformatted) ftc__unit_error(id, "unformatted transfer on a formatted unit");
+    return unit;
+}
+
+static void ftc__write_bytes(ftc__unit* unit, const void* data, size_t bytes) {
+    if(fwrite(data, 1, bytes, unit->file)!=bytes) ftc__unit_error(unit->id, strerror(errno));
+}
+
+static void ftc__write_marker(ftc__unit* unit, size_t len, int negate) {
+    int marker = negate ? -(int)len : (int)len;
+    ftc__write_bytes(unit, &marker, sizeof(marker));
+}
+
+/* leading marker of the next subrecord of the record being written. */
+static void ftc__write_subrecord(ftc__unit* unit) {
+    size_t len = unit->rec_left < FTC__SUBRECORD ? unit->rec_left : FTC__SUBRECORD;
+    unit->rec_left -= len;
+    unit->sub_len = unit->sub_left = len;
+    ftc__write_marker(unit, len, unit->rec_left>0);
+}
+
+void ftc__write_record(int id, size_t bytes) {
+    ftc__unit* unit = ftc__unformatted_unit(id);
+    if(unit->stream) return;
+
+    unit->rec_left = bytes;
+    unit->continued = 0;
+    ftc__write_subrecord(unit);
+}
+
+void ftc__write_data(int id, const void* data, size_t bytes) {
+    ftc__unit* unit = ftc__unformatted_unit(id);
+    if(unit->stream) {
+        ftc__write_bytes(unit, data, bytes);
+        return;
+    }
+
+    while(bytes>0) {
+        size_t n;
+        if(unit->sub_left==0) {
+            if(unit->rec_left==0) ftc__unit_error(id, "record overflow writing");
+            ftc__write_marker(unit, unit->sub_len, unit->continued);
+            unit->continued = 1;
+            ftc__write_subrecord(unit);
+        }
+
+        n = bytes < unit->sub_left ? bytes : unit->sub_left;
+        ftc__write_bytes(unit, data, n);
+        data = (const char*)data + n;
+        bytes -= n;
+        unit->sub_left -= n;
+    }
+}
+
+void ftc__write_record_end(int id) {
+    ftc__unit* unit = ftc__unformatted_unit(id);
+    if(unit->stream) return;
+
+    if(unit->sub_left!=0 || unit->rec_left!=0) ftc__unit_error(id, "short record writing");
+    ftc__write_marker(unit, unit->sub_len, unit->continued);
+}
+
+static void ftc__read_bytes(ftc__unit* unit, void* data, size_t bytes) {
+    if(unit->mapped) {
+        if(unit->len - unit->pos < bytes) ftc__unit_error(unit->id, "end of file reading");
+        memcpy(data, unit->buf + unit->pos, bytes);
+        unit->pos += bytes;
+        return;
+    }
+    if(fread(data, 1, bytes, unit->file)!=bytes) {
+        if(ferror(unit->file)) ftc__unit_error(unit->id, strerror(errno));
+        ftc__unit_error(unit->id, "end of file reading");
+    }
+}
+
+/* the next subrecord's leading marker. */
+static void ftc__read_subrecord(ftc__unit* unit) {
+    int marker;
+    ftc__read_bytes(unit, &marker, sizeof(marker));
+    unit->more = marker<0;
+    unit->sub_left = marker<0 ? -(long)marker : marker;
+}
+
+/* past the rest of the current subrecord and its trailing marker. */
+static void ftc__skip_subrecord(ftc__unit* unit) {
+    size_t bytes = unit->sub_left + sizeof(int);
+    unit->sub_left = 0;
+
+    if(unit->mapped) {
+        if(unit->len - unit->pos < bytes) ftc__unit_error(unit->id, "end of file reading");
+        unit->pos += bytes;
+        return;
+    }
+
+    if(fseeko(unit->file, (off_t)bytes, SEEK_CUR)==0) return;
+
+    /* not seekable */
+    while(bytes>0) {
+        char discard[4096];
+        size_t n = bytes < sizeof(discard) ? bytes : sizeof(discard);
+        ftc__read_bytes(unit, discard, n);
+        bytes -= n;
+    }
+}
+
+void ftc__read_record(int id) {
+    ftc__unit* unit = ftc__unformatted_unit(id);
+    if(unit->stream) return;
+    ftc__read_subrecord(unit);
+}
+
+void ftc__read_data(int id, void* data, size_t bytes) {
+    ftc__unit* unit = ftc__unformatted_unit(id);
+    if(unit->stream) {
+        ftc__read_bytes(unit, data, bytes);
+        return;
+    }
+
+    while(bytes>0) {
+        size_t n;
+        if(unit->sub_left==0) {
+            if(!unit->more) ftc__unit_error(id, "record too short reading");
+            ftc__skip_subrecord(unit);
+            ftc__read_subrecord(unit);
+        }
+
+        n = bytes < unit->sub_left ? bytes : unit->sub_left;
+        ftc__read_bytes(unit, data, n);
+        data = (char*)data + n;
+        bytes -= n;
+        unit->sub_left -= n;
+    }
+}
+
+void ftc__read_record_end(int id) {
+    ftc__unit* unit = ftc__unformatted_unit(id);
+    if(unit->stream) return;
+
+    ftc__skip_subrecord(unit);
+    while(unit->more) {
+        ftc__read_subrecord(unit);
+        ftc__skip_subrecord(unit);
     }
 }
@@ -5,28 +5,102 @@
 /**
 
     Wrapper for FORTAN file io.
-    
+
     open (id, file=path)
     write (id,*) "hello"
+    read (id,*) n, x
     close (id)
-    
+    open (id, file=path, form='unformatted')
+    write (id) n, a
+
     becomes
-    
+
     #include "$FTC/ftc_file_io.h"
-    
+
     ftc__open_file(id,path);
-    fprintf(ftc__get_file(id), "%s\n", "hello");
+    ftc__write_string(id,"hello",-1);
+    ftc__write_end(id);
+    ftc__read_int(id,&n);
+    ftc__read_double(id,&x);
+    ftc__read_end(id);
     ftc__close_file(id);
-    
+    ftc__open(id,path,0,0,"unformatted",0,0);
+    ftc__write_record(id,sizeof(n) + sizeof(double)*100);
+    ftc__write_data(id,&n,sizeof(n));
+    ftc__write_data(id,a,sizeof(double)*100);
+    ftc__write_record_end(id);
+
+    units 5 and 6 are preconnected to stdin and stdout.
+
 **/
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/*
+    OPEN. the specifiers are fortran strings, NULL when not given: status (old, new, replace,
+    scratch, unknown), access (sequential, stream), form (formatted, unformatted), action
+    (read, write, readwrite) and position (asis, rewind, append). ftc__open_file(id,path)
+    opens with none given.
+*/
+void ftc__open(int id, const char* path, const char* status, const char* access,
+               const char* form, const char* action, const char* position);
 void ftc__open_file(int id, const char* path);
 FILE* ftc__get_file(int id);
-void ftc__close_file(int id);  
+void ftc__close_file(int id);
+
+/*
+    list-directed input. each call reads the next value of the current READ statement,
+    following fortran's rules: values are separated by blanks, a comma or the end of a
+    record, r*c stands for r copies of c, a null value (r* or an empty field between commas)
+    and every value after a '/' leave the item unchanged. ftc__read_end ends the statement,
+    skipping the rest of its last record.
+
+    a string is read into len chars padded with blanks, or when len<0 nul terminated.
+*/
+void ftc__read_int(int id, int* value);
+void ftc__read_long(int id, long* value);
+void ftc__read_float(int id, float* value);
+void ftc__read_double(int id, double* value);
+void ftc__read_string(int id, char* value, long len);
+void ftc__read_end(int id);
+
+/* n values, stride elements apart: an implied DO (a(i), i=1,n) or an array section. */
+void ftc__read_ints(int id, int* values, long n, long stride);
+void ftc__read_longs(int id, long* values, long n, long stride);
+void ftc__read_floats(int id, float* values, long n, long stride);
+void ftc__read_doubles(int id, double* values, long n, long stride);
+
+/*
+    list-directed output. values are added to the unit's current record, numbers after a
+    blank unless they start it; ftc__write_end ends the record and writes it out in one go.
+    a string of len<0 is nul terminated.
+*/
+void ftc__write_int(int id, int value);
+void ftc__write_long(int id, long value);
+void ftc__write_float(int id, float value);
+void ftc__write_double(int id, double value);
+void ftc__write_string(int id, const char* value, long len);
+void ftc__write_ints(int id, const int* values, long n, long stride);
+void ftc__write_longs(int id, const long* values, long n, long stride);
+void ftc__write_floats(int id, const float* values, long n, long stride);
+void ftc__write_doubles(int id, const double* values, long n, long stride);
+void ftc__write_end(int id);
+
+/*
+    unformatted input/output, one block of bytes per item. a record is written as
+    ftc__write_record with its total length, ftc__write_data per item, then
+    ftc__write_record_end; read as ftc__read_record, ftc__read_data per item, then
+    ftc__read_record_end, which skips what is left of it. sequential files have gfortran's
+    record markers, stream files none.
+*/
+void ftc__write_record(int id, size_t bytes);
+void ftc__write_data(int id, const void* data, size_t bytes);
+void ftc__write_record_end(int id);
+void ftc__read_record(int id);
+void ftc__read_data(int id, void* data, size_t bytes);
+void ftc__read_record_end(int id);
 
 #ifdef __cplusplus
 }
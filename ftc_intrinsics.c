@@ -0,0 +1,104 @@
+#include "ftc_intrinsics.h"
+#include <float.h>
+#include <limits.h>
+
+/*
+    reductions keep 8 independent partial results, combined at the end, so the main loop
+    vectorises without the compiler having to reassociate the operation itself.
+*/
+
+#define FTC__FOLD(name, T, init, op) \
+T ftc__##name(const T* a, long n) { \
+    T p[8]; \
+    long i; \
+    int j; \
+    for(j = 0; j<8; j++) p[j] = init; \
+    for(i = 0; i+8<=n; i+=8) \
+        for(j = 0; j<8; j++) p[j] = p[j] op a[i+j]; \
+    for(; i<n; i++) p[0] = p[0] op a[i]; \
+    return ((p[0] op p[1]) op (p[2] op p[3])) op ((p[4] op p[5]) op (p[6] op p[7])); \
+}
+
+#define FTC__EXTREMUM(name, T, init, cmp) \
+T ftc__##name(const T* a, long n) { \
+    T p[8]; \
+    long i; \
+    int j; \
+    for(j = 0; j<8; j++) p[j] = init; \
+    for(i = 0; i+8<=n; i+=8) \
+        for(j = 0; j<8; j++) p[j] = a[i+j] cmp p[j] ? a[i+j] : p[j]; \
+    for(; i<n; i++) p[0] = a[i] cmp p[0] ? a[i] : p[0]; \
+    for(j = 1; j<8; j++) p[0] = p[j] cmp p[0] ? p[j] : p[0]; \
+    return p[0]; \
+}
+
+#define FTC__DOT(name, T) \
+T ftc__##name(const T* x, const T* y, long n) { \
+    T p[8]; \
+    long i; \
+    int j; \
+    for(j = 0; j<8; j++) p[j] = 0; \
+    for(i = 0; i+8<=n; i+=8) \
+        for(j = 0; j<8; j++) p[j] += x[i+j]*y[i+j]; \
+    for(; i<n; i++) p[0] += x[i]*y[i]; \
+    return ((p[0] + p[1]) + (p[2] + p[3])) + ((p[4] + p[5]) + (p[6] + p[7])); \
+}
+
+/*
+    c = a*b, column major. c is zeroed, then accumulated a block of FTC__MM_ROWS rows by
+    FTC__MM_DEPTH columns of a at a time, which stays in cache while it is used against every
+    column of b. the innermost loop runs down a column of both c and a, contiguously.
+*/
+
+#define FTC__MM_ROWS  64
+#define FTC__MM_DEPTH 256
+
+#define FTC__MATMUL(name, T) \
+void ftc__##name(T* c, const T* a, const T* b, long m, long k, long n) { \
+    long i, j, p, ii, pp; \
+    for(i = 0; i<m*n; i++) c[i] = 0; \
+    for(pp = 0; pp<k; pp+=FTC__MM_DEPTH) { \
+        long pend = pp+FTC__MM_DEPTH<k ? pp+FTC__MM_DEPTH : k; \
+        for(ii = 0; ii<m; ii+=FTC__MM_ROWS) { \
+            long iend = ii+FTC__MM_ROWS<m ? ii+FTC__MM_ROWS : m; \
+            for(j = 0; j<n; j++) { \
+                T* restrict cj = c + j*m; \
+                for(p = pp; p<pend; p++) { \
+                    const T* restrict ap = a + p*m; \
+                    T bpj = b[p + j*k]; \
+                    for(i = ii; i<iend; i++) cj[i] += ap[i]*bpj; \
+                } \
+            } \
+        } \
+    } \
+}
+
+FTC__FOLD(sum_r8, double, 0, +)
+FTC__FOLD(sum_r4, float,  0, +)
+FTC__FOLD(sum_i4, int,    0, +)
+FTC__FOLD(sum_i8, long,   0, +)
+
+FTC__FOLD(product_r8, double, 1, *)
+FTC__FOLD(product_r4, float,  1, *)
+FTC__FOLD(product_i4, int,    1, *)
+FTC__FOLD(product_i8, long,   1, *)
+
+FTC__EXTREMUM(maxval_r8, double, -DBL_MAX, >)
+FTC__EXTREMUM(maxval_r4, float,  -FLT_MAX, >)
+FTC__EXTREMUM(maxval_i4, int,    INT_MIN,  >)
+FTC__EXTREMUM(maxval_i8, long,   LONG_MIN, >)
+
+FTC__EXTREMUM(minval_r8, double, DBL_MAX,  <)
+FTC__EXTREMUM(minval_r4, float,  FLT_MAX,  <)
+FTC__EXTREMUM(minval_i4, int,    INT_MAX,  <)
+FTC__EXTREMUM(minval_i8, long,   LONG_MAX, <)
+
+FTC__DOT(dot_product_r8, double)
+FTC__DOT(dot_product_r4, float)
+FTC__DOT(dot_product_i4, int)
+FTC__DOT(dot_product_i8, long)
+
+FTC__MATMUL(matmul_r8, double)
+FTC__MATMUL(matmul_r4, float)
+FTC__MATMUL(matmul_i4, int)
+FTC__MATMUL(matmul_i8, long)
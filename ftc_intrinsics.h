@@ -0,0 +1,61 @@
+#pragma once
+
+/**
+
+    Runtime for FORTRAN array intrinsics, one entry point per kind:
+    
+        _r8 double, _r4 float, _i4 int, _i8 long
+    
+    sum(a)              -> ftc__sum_r8(a, n)
+    product(a)          -> ftc__product_r8(a, n)
+    maxval(a)           -> ftc__maxval_r8(a, n)
+    minval(a)           -> ftc__minval_r8(a, n)
+    dot_product(x,y)    -> ftc__dot_product_r8(x, y, n)
+    c = matmul(a,b)     -> ftc__matmul_r8(c, a, b, m, k, n)
+    
+    arrays are contiguous, n elements long; matmul's are column major, a being m x k, b k x n
+    and c m x n (m is 1 for a vector a, n is 1 for a vector b). as in FORTRAN maxval and minval
+    of no elements are -huge and huge.
+    
+    the translator only calls these for contiguous arguments; other array expressions are
+    reduced in place.
+    
+**/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+double ftc__sum_r8(const double* a, long n);
+float  ftc__sum_r4(const float*  a, long n);
+int    ftc__sum_i4(const int*    a, long n);
+long   ftc__sum_i8(const long*   a, long n);
+
+double ftc__product_r8(const double* a, long n);
+float  ftc__product_r4(const float*  a, long n);
+int    ftc__product_i4(const int*    a, long n);
+long   ftc__product_i8(const long*   a, long n);
+
+double ftc__maxval_r8(const double* a, long n);
+float  ftc__maxval_r4(const float*  a, long n);
+int    ftc__maxval_i4(const int*    a, long n);
+long   ftc__maxval_i8(const long*   a, long n);
+
+double ftc__minval_r8(const double* a, long n);
+float  ftc__minval_r4(const float*  a, long n);
+int    ftc__minval_i4(const int*    a, long n);
+long   ftc__minval_i8(const long*   a, long n);
+
+double ftc__dot_product_r8(const double* x, const double* y, long n);
+float  ftc__dot_product_r4(const float*  x, const float*  y, long n);
+int    ftc__dot_product_i4(const int*    x, const int*    y, long n);
+long   ftc__dot_product_i8(const long*   x, const long*   y, long n);
+
+void ftc__matmul_r8(double* c, const double* a, const double* b, long m, long k, long n);
+void ftc__matmul_r4(float*  c, const float*  a, const float*  b, long m, long k, long n);
+void ftc__matmul_i4(int*    c, const int*    a, const int*    b, long m, long k, long n);
+void ftc__matmul_i8(long*   c, const long*   a, const long*   b, long m, long k, long n);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,77 @@
+#pragma once
+
+/**
+
+    Exponentiation for FORTRAN ** where libm's pow isn't needed.
+    
+    i**j     -> ftc__ipow(i,j)       (ftc__ipowl for integer(8))
+    x**j     -> ftc__powi(x,j)       (ftc__powif for real(4))
+    
+    small constant exponents are instead expanded by the translator into multiplications;
+    real exponents still use pow/powf.
+    
+    everything is static inline so that calls with a constant exponent fold away.
+    
+**/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* integer power; as in FORTRAN a negative exponent gives 1/base**|exp| truncated. */
+static inline int ftc__ipow(int base, int exp) {
+    int ret = 1;
+    if(exp<0) {
+        if(base==1) return 1;
+        if(base==-1) return (exp&1) ? -1 : 1;
+        return 0;
+    }
+    while(exp!=0) {
+        if(exp&1) ret *= base;
+        exp >>= 1;
+        if(exp!=0) base *= base; /* not past the last bit: it could overflow */
+    }
+    return ret;
+}
+
+static inline long ftc__ipowl(long base, long exp) {
+    long ret = 1;
+    if(exp<0) {
+        if(base==1) return 1;
+        if(base==-1) return (exp&1) ? -1 : 1;
+        return 0;
+    }
+    while(exp!=0) {
+        if(exp&1) ret *= base;
+        exp >>= 1;
+        if(exp!=0) base *= base; /* not past the last bit: it could overflow */
+    }
+    return ret;
+}
+
+/* real base, integer exponent; by repeated squaring. */
+static inline double ftc__powi(double base, int exp) {
+    double ret = 1.0;
+    unsigned int n = exp<0 ? -(unsigned int)exp : (unsigned int)exp;
+    while(n!=0) {
+        if(n&1) ret *= base;
+        n >>= 1;
+        base *= base;
+    }
+    return exp<0 ? 1.0/ret : ret;
+}
+
+static inline float ftc__powif(float base, int exp) {
+    float ret = 1.0f;
+    unsigned int n = exp<0 ? -(unsigned int)exp : (unsigned int)exp;
+    while(n!=0) {
+        if(n&1) ret *= base;
+        n >>= 1;
+        base *= base;
+    }
+    return exp<0 ? 1.0f/ret : ret;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <rose.h>
+#include <vector>
+#include <map>
+#include <set>
+#include <string>
+
+//true for command line arguments naming a fortran source file.
+bool is_fortran_source(const std::string& arg);
+
+//the modules a (free form) fortran source defines and uses, and the (lower cased) procedures
+//it defines outside of modules, found without parsing it.
+void scan_modules(const std::string& text, std::set<std::string>& defines, std::set<std::string>& uses,
+                  std::set<std::string>& procedures);
+
+bool read_file(const std::string& path, std::string& data);
+
+/*
+    On-disk cache of translated .c/.h pairs (--cache DIR).
+
+    A fortran input is reused from the cache, and not even given to the frontend, when its
+    source hash is unchanged and none of the modules it uses (directly or through other
+    modules) or external procedures it calls are defined by a changed file. Other unchanged
+    inputs are still parsed so the new interface fingerprints can be compared with the ones
+    they were translated against; they are only re-translated if one differs. A module's
+    fingerprint covers the argument intents of its procedures, its declarations (PARAMETER
+    values, variable types and extents) and the fingerprints of the modules it uses; an
+    external procedure's covers its argument intents.
+*/
+class TranslationCache {
+public:
+    TranslationCache(const std::string& dir);
+
+    //before the frontend: check every fortran input on the command line against the cache.
+    //returns the command line the frontend should be run with instead.
+    std::vector<std::string> plan(const std::vector<std::string>& argv);
+
+    //true if any input has to be given to the frontend at all.
+    bool needs_frontend() const;
+
+    //after the frontend: given the loaded input files, decide which need translating.
+    //the interfaces of procedures in inputs that weren't loaded are made known to the translator.
+    std::vector<SgFile*> select(const std::vector<SgFile*>& loaded);
+
+    //module name -> header, for modules defined by inputs that aren't being translated.
+    std::map<std::string,std::string> module_headers() const;
+
+    //put the cached .c/.h of every input not being translated in place.
+    bool restore();
+
+    //save the translations of the given (successfully translated) files.
+    void store(const std::vector<SgFile*>& translated);
+
+private:
+    enum State { CLEAN, PENDING, DIRTY };
+
+    struct Source {
+        std::string path;      //as given on the command line
+        std::string real;      //absolute path
+        std::string key;       //name of its cache entry
+        std::string hash;      //of the source text
+        std::set<std::string> defines;
+        std::set<std::string> uses;
+        std::set<std::string> procedures; //defined outside of modules.
+
+        bool cached;           //entry exists and source unchanged.
+        std::map<std::string,std::string> used_fingerprints;   //as recorded in the entry.
+        std::map<std::string,std::string> called_fingerprints; //as recorded in the entry.
+        std::vector<std::string> procs; //interface lines.
+        std::vector<std::string> calls; //procedures called.
+
+        State state;
+        bool load;             //given to the frontend.
+        bool translate;        //translated this run.
+    };
+
+    std::string dir;
+    std::vector<Source> sources;
+    std::map<std::string,int> definer;             //module -> index of source defining it.
+    std::map<std::string,std::string> fingerprints; //module -> interface fingerprint.
+    std::map<std::string,std::string> external_fingerprints; //external procedure -> interface fingerprint.
+
+    bool read_entry(Source& source);
+    std::string fingerprint(const std::string& module, const std::map<std::string,std::string>& interfaces);
+    std::string output(const Source& source, const std::string& ext) const;
+    std::string entry(const Source& source, const std::string& ext) const;
+};
@@ -2,5 +2,38 @@
 
 #include <rose.h>
 #include <vector>
+#include <map>
+#include <string>
 
 extern std::vector<SgGlobal*> input_globals;
+
+//options for ftc itself, taken off the command line before it is given to rose.
+struct FtcOptions {
+    int jobs;              //-j N: number of worker processes translating at once.
+    std::string cache_dir; //--cache DIR: reuse translations of unchanged files from DIR.
+    
+    bool time_report;             //--time-report: print time/memory report at exit.
+    std::string time_report_json; //--time-report-json=PATH: write it as JSON to PATH ('-' stdout).
+    int time_report_top;          //--time-report-top=N: number of slowest files listed.
+    
+    bool stream;           //--stream: parse, translate and release one input file at a time.
+    bool no_restrict;      //--no-restrict: for codes whose procedure arguments alias.
+    bool copy_scalars;     //--copy-scalars: copy-in/copy-out for scalar out/inout arguments.
+    
+    FtcOptions() : jobs(1), time_report(false), time_report_top(10), stream(false), no_restrict(false),
+        copy_scalars(false) {}
+};
+
+//translate the given input files, add their include directives and headers, and unparse them.
+//
+//module_headers names the header of each used module NOT defined by one of 'files'.
+//if 'defined' is non-NULL, the headers of modules that ARE defined by 'files' are added to it.
+//if 'release' is set, the C ASTs are deleted once unparsed.
+int translate_files(const std::vector<SgFile*>& files,
+    const std::map<std::string,std::string>& module_headers,
+    std::map<std::string,std::string>* defined,
+    bool release = false
+);
+
+//false for the files rose generates for modules, that weren't given on the command line.
+bool is_input_file(const SgFile& file, const std::vector<std::string>& argv);
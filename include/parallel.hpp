@@ -0,0 +1,15 @@
+#pragma once
+
+#include <rose.h>
+#include <vector>
+#include <map>
+#include <string>
+
+//translate the input files with up to 'jobs' worker processes at once.
+//
+//a file is only handed to a worker once every file defining a module it uses has been
+//translated, so that the module headers it must include are known. module_headers gives the
+//headers of modules defined by files that aren't being translated at all.
+int translate_parallel(const std::vector<SgFile*>& files,
+    const std::map<std::string,std::string>& module_headers, int jobs
+);
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+//translate the fortran inputs on the command line one at a time (--stream), releasing each
+//file's fortran and C ASTs once it has been unparsed.
+//
+//inputs are taken in command line order, so a file must come after those defining the
+//modules it uses and the procedures outside of modules it calls.
+int translate_streaming(const std::vector<std::string>& argv);
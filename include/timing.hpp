@@ -0,0 +1,59 @@
+#pragma once
+
+#include <rose.h>
+#include <iosfwd>
+#include <vector>
+#include <map>
+#include <string>
+
+/*
+    --time-report: wall time, cpu time and peak memory of each phase of a run, per input file,
+    plus a count of the nodes translated by Sage class.
+*/
+class TimeReport {
+public:
+    struct Phase {
+        std::string name;  //frontend, xf_file, xf_gen_header, unparse, total.
+        std::string file;  //absolute path of the input file the phase worked on, if any.
+        double wall;       //seconds
+        double cpu;        //seconds
+        long peak_rss;     //kilobytes, high water mark of the process at the end of the phase.
+    };
+
+    bool enabled;
+    std::vector<Phase> phases;
+    std::map<std::string, long> nodes;
+
+    TimeReport() : enabled(false) {}
+
+    void count(SgNode* n) {
+        if(enabled) nodes[n->sage_class_name()]++;
+    }
+
+    void print(std::ostream& out, int slowest) const;
+    void print_json(std::ostream& out, int slowest) const;
+
+    //used to pass the report of a worker process back to the coordinator.
+    std::string serialize() const;
+    void merge(const std::string& report);
+
+private:
+    long total_nodes() const;
+    double translate_time() const;
+    std::vector<std::pair<std::string,double>> slowest_files(int n) const;
+};
+
+extern TimeReport time_report;
+
+//measures from construction until stop() (or destruction) into time_report.
+class PhaseTimer {
+    std::string name;
+    std::string file;
+    double wall;
+    double cpu;
+    bool running;
+public:
+    PhaseTimer(const std::string& name, const std::string& file = "");
+    ~PhaseTimer();
+    void stop();
+};
@@ -1,23 +1,64 @@
 #pragma once
 #include "rose.h"
+#include "traversal.hpp"
 #include <vector>
 #include <map>
+#include <set>
 #include <string>
 
 namespace ftc {
 
-    class GFinder : public AstSimpleProcessing {
+    //options changing the C generated by the translator.
+    struct XfOptions {
+        bool restrict_args; //pointer arguments are restrict (--no-restrict clears it).
+        bool copy_scalars;  //scalar out/inout arguments are copied to a local at entry and
+                            //written back on return (--copy-scalars).
+        
+        XfOptions() : restrict_args(true), copy_scalars(false) {}
+    };
+    extern XfOptions xf_options;
+    
+    //xf_options as a string, for anything keyed on how a file was translated (see cache.cpp).
+    std::string xf_options_signature();
+
+    //global scope of a file, or the first one found under any other node.
+    class GFinder : public PruningTraversal {
         SgGlobal* ret;
+    protected:
+        bool preOrderVisit(SgNode* n);
     public:
-        void visit(SgNode* n);
         SgGlobal* find(SgNode* root);
     };
 
-    SgFile* xf_file(SgFile*, SgProject**,
+    //index every procedure declaration in the given input files by name.
+    //must be called before translation so call sites can find their callees.
+    void xf_index_fn_decls(const std::vector<SgGlobal*>&);
+
+    //one line summary of the argument intents of every procedure defined in a fortran file.
+    std::vector<std::string> xf_fn_interfaces(SgFile*);
+    
+    //names of the procedures called in a file (intrinsics included).
+    std::vector<std::string> xf_fn_calls(SgFile*);
+    
+    //make procedures summarised by xf_fn_interfaces callable when their source is not loaded.
+    void xf_load_fn_interfaces(const std::vector<std::string>&);
+    
+    //replace the indexed declarations of the given fortran files by their interface summaries,
+    //so the files' ASTs can be deleted.
+    void xf_release_fn_decls(const std::vector<SgFile*>&);
+
+    //(lower cased) names of procedures outside of modules that are defined by input files not
+    //loaded yet (--stream). translating a call to one is an error.
+    void xf_set_later_fns(const std::set<std::string>&);
+
+        SgFile* xf_file(SgFile*, SgProject**,
     
         std::map<std::string,SgFile*>&,
         std::vector<std::pair<SgGlobal*,std::string>>&
     );
     
     SgFile* xf_gen_header(SgFile*, SgProject*);
+    
+    //delete the translator's own attributes on a translated C file, before its AST is deleted.
+    void xf_release_attributes(SgFile*);
 }
@@ -0,0 +1,46 @@
+#pragma once
+#include <rose.h>
+#include <vector>
+
+namespace ftc {
+
+    /*
+        pre/post order traversal where preOrderVisit decides whether the children of a node
+        are visited at all. nodes translated as a whole (statements, declarations, nested
+        blocks handed to their own visitor) return false so their subtrees are never walked,
+        keeping a translation pass linear in the size of the AST.
+
+        a visitor that has found what it was looking for calls stop() to end the whole
+        traversal; no further nodes are visited, pre or post order.
+    */
+    class PruningTraversal {
+        bool stopped;
+
+        void walk(SgNode* n) {
+            if(n==NULL) return;
+
+            if(preOrderVisit(n)) {
+                std::vector<SgNode*> children = n->get_traversalSuccessorContainer();
+                for(auto i = children.begin(); i!=children.end() && !stopped; i++)
+                    walk(*i);
+            }
+            if(!stopped) postOrderVisit(n);
+        }
+
+    public:
+        PruningTraversal() : stopped(false) {}
+        virtual ~PruningTraversal() {}
+
+        void traverse(SgNode* root) {
+            stopped = false;
+            walk(root);
+        }
+
+    protected:
+        //return true to descend into the children of n.
+        virtual bool preOrderVisit(SgNode* n) = 0;
+        virtual void postOrderVisit(SgNode* n) {}
+
+        void stop() { stopped = true; }
+    };
+}
@@ -0,0 +1,471 @@
+#include "cache.hpp"
+#include "translator.hpp"
+#include <rose.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <map>
+#include <set>
+#include <cctype>
+#include <climits>
+#include <cstdlib>
+#include <cstdio>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using std::cout;
+using std::endl;
+using std::vector;
+using std::string;
+using std::map;
+using std::set;
+using std::ifstream;
+using std::ofstream;
+using std::stringstream;
+
+///_________________________________________________________________________________________________
+///
+
+//FNV-1a, 64 bit, as hex.
+string hash_string(const string& data) {
+    unsigned long long h = 14695981039346656037ULL;
+    for(unsigned int i = 0; i<data.size(); i++) {
+        h ^= (unsigned char)data[i];
+        h *= 1099511628211ULL;
+    }
+    char out[17];
+    snprintf(out, sizeof(out), "%016llx", h);
+    return string(out);
+}
+
+bool read_file(const string& path, string& data) {
+    ifstream in (path.c_str(), std::ios::in | std::ios::binary);
+    if(!in) return false;
+    stringstream buffer;
+    buffer << in.rdbuf();
+    data = buffer.str();
+    return true;
+}
+
+bool copy_file(const string& from, const string& to) {
+    string data;
+    if(!read_file(from, data)) return false;
+    ofstream out (to.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!out) return false;
+    out << data;
+    return (bool)out;
+}
+
+bool file_exists(const string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st)==0;
+}
+
+bool is_fortran_source(const string& arg) {
+    if(arg.empty() || arg[0]=='-') return false;
+    size_t dot = arg.find_last_of('.');
+    if(dot==string::npos) return false;
+
+    string ext = arg.substr(dot+1);
+    for(unsigned int i = 0; i<ext.size(); i++) ext[i] = tolower(ext[i]);
+    return ext=="f" || ext=="f77" || ext=="f90" || ext=="f95" || ext=="f03" || ext=="f08";
+}
+
+//leading identifier of 's', lower cased.
+string identifier(const string& s) {
+    string ret;
+    for(unsigned int i = 0; i<s.size() && (isalnum(s[i]) || s[i]=='_'); i++)
+        ret += tolower(s[i]);
+    return ret;
+}
+
+//name of the procedure a (lower cased) statement starts with the 'keyword' of, or "".
+string procedure_name(const string& line, const string& keyword) {
+    if(line.compare(0,3,"end")==0) return "";
+
+    size_t at = line.find(keyword + " ");
+    while(at!=string::npos && at!=0 && line[at-1]!=' ' && line[at-1]!=')')
+        at = line.find(keyword + " ", at+1);
+    if(at==string::npos || line.substr(0,at).find_first_of("=\'\"")!=string::npos) return "";
+
+    size_t name = line.find_first_not_of(" \t", at+keyword.size());
+    return name==string::npos ? "" : identifier(line.substr(name));
+}
+
+//the modules a (free form) fortran source defines and uses, and the procedures it defines
+//outside of modules, found without parsing it.
+void scan_modules(const string& text, set<string>& defines, set<string>& uses, set<string>& procedures) {
+    stringstream in (text);
+    string line;
+    int modules = 0;
+    while(getline(in, line)) {
+        line = line.substr(0, line.find('!'));
+
+        size_t start = line.find_first_not_of(" \t");
+        if(start==string::npos) continue;
+        line.erase(0, start);
+        for(unsigned int i = 0; i<line.size(); i++) line[i] = tolower(line[i]);
+
+        if(line.compare(0,7,"module ")==0) {
+            size_t name = line.find_first_not_of(" \t",7);
+            if(name==string::npos) continue;
+            string module = identifier(line.substr(name));
+            if(!module.empty() && module!="procedure") {
+                defines.insert(module);
+                modules++;
+            }
+        }else if(line.compare(0,3,"use")==0 && line.size()>3 && (line[3]==' ' || line[3]==',' || line[3]=='\t')) {
+            string rest = line.substr(3);
+            size_t colons = rest.find("::");
+            if(colons!=string::npos)
+                rest.erase(0, colons+2);
+            size_t name = rest.find_first_not_of(" \t");
+            if(name!=string::npos)
+                uses.insert(identifier(rest.substr(name)));
+        }else if(line.compare(0,3,"end")==0) {
+            size_t word = line.find_first_not_of(" \t",3);
+            if(word!=string::npos && line.compare(word,6,"module")==0 && modules>0)
+                modules--;
+        }else if(modules==0) {
+            string name = procedure_name(line, "subroutine");
+            if(name.empty()) name = procedure_name(line, "function");
+            if(!name.empty()) procedures.insert(name);
+        }
+    }
+}
+
+string real_path(const string& path) {
+    char buffer[PATH_MAX];
+    if(realpath(path.c_str(), buffer)==NULL) return path;
+    return string(buffer);
+}
+
+///_________________________________________________________________________________________________
+///
+
+TranslationCache::TranslationCache(const string& dir) {
+    this->dir = dir;
+    if(!this->dir.empty() && this->dir[this->dir.size()-1]!='/')
+        this->dir.append("/");
+}
+
+string TranslationCache::output(const Source& source, const string& ext) const {
+    //same naming as ftc::xf_file / ftc::xf_gen_header
+    string name = source.real;
+    name.erase(name.find_last_of('.'));
+    return name.append(ext);
+}
+
+string TranslationCache::entry(const Source& source, const string& ext) const {
+    return dir + source.key + ext;
+}
+
+/*
+    entry format:
+
+        ftc-cache 2
+        source <hash>
+        use <module> <fingerprint>
+        call <procedure> <fingerprint>
+        proc ... (see ftc::xf_fn_interfaces)
+        decl ...
+*/
+bool TranslationCache::read_entry(Source& source) {
+    string data;
+    if(!read_file(entry(source, ".entry"), data)) return false;
+
+    stringstream in (data);
+    string line;
+    getline(in, line);
+    if(line!="ftc-cache 2") return false;
+
+    string hash;
+    while(getline(in, line)) {
+        stringstream fields (line);
+        string tag;
+        fields >> tag;
+        if(tag=="source")
+            fields >> hash;
+        else if(tag=="use") {
+            string module, fingerprint;
+            fields >> module >> fingerprint;
+            source.used_fingerprints[module] = fingerprint;
+        }else if(tag=="call") {
+            string procedure, fingerprint;
+            fields >> procedure >> fingerprint;
+            source.called_fingerprints[procedure] = fingerprint;
+        }else if(tag=="proc" || tag=="decl")
+            source.procs.push_back(line);
+    }
+
+    return hash==source.hash
+        && file_exists(entry(source, ".c"))
+        && file_exists(entry(source, ".h"));
+}
+
+vector<string> TranslationCache::plan(const vector<string>& argv) {
+    if(!file_exists(dir) && mkdir(dir.c_str(), 0755)!=0)
+        cout << "WARNING: couldn't create cache directory " << dir << endl;
+
+    for(unsigned int i = 1; i<argv.size(); i++) {
+        if(!is_fortran_source(argv[i])) continue;
+
+        Source source;
+        source.path = argv[i];
+        source.real = real_path(argv[i]);
+
+        string name = source.real.substr(source.real.find_last_of('/')+1);
+        source.key = name + "-" + hash_string(source.real).substr(0,8);
+
+        string text;
+        if(read_file(source.path, text)) {
+            //the same source translated with different options is a different entry.
+            source.hash = hash_string(text + ftc::xf_options_signature());
+            scan_modules(text, source.defines, source.uses, source.procedures);
+            source.cached = read_entry(source);
+        }else
+            source.cached = false;
+
+        source.state = source.cached ? CLEAN : DIRTY;
+        source.load = !source.cached;
+        source.translate = false;
+
+        for(auto j = source.defines.begin(); j!=source.defines.end(); j++)
+            definer[*j] = sources.size();
+        sources.push_back(source);
+    }
+
+    //external procedure -> sources that might define it.
+    map<string,vector<int>> procedure_definers;
+    for(unsigned int i = 0; i<sources.size(); i++)
+        for(auto j = sources[i].procedures.begin(); j!=sources[i].procedures.end(); j++)
+            procedure_definers[*j].push_back(i);
+
+    //unchanged files might see a new interface when a module they use (directly, or through
+    //another module) or an external procedure they call is defined by a changed file.
+    bool changed = true;
+    while(changed) {
+        changed = false;
+        for(auto i = sources.begin(); i!=sources.end(); i++) {
+            if((*i).state!=CLEAN) continue;
+
+            bool pending = false;
+            for(auto j = (*i).uses.begin(); j!=(*i).uses.end() && !pending; j++) {
+                auto def = definer.find(*j);
+                pending = def!=definer.end() && sources[(*def).second].state!=CLEAN;
+            }
+            for(auto j = (*i).called_fingerprints.begin(); j!=(*i).called_fingerprints.end() && !pending; j++) {
+                auto defs = procedure_definers.find(identifier((*j).first));
+                if(defs==procedure_definers.end()) continue;
+                for(auto k = (*defs).second.begin(); k!=(*defs).second.end(); k++)
+                    if(sources[*k].state!=CLEAN) pending = true;
+            }
+
+            if(pending) {
+                (*i).state = PENDING;
+                (*i).load = true;
+                changed = true;
+            }
+        }
+    }
+
+    //the frontend needs the rose module file (.rmod) of every module a loaded file uses;
+    //if a previous run didn't leave one behind, load the file defining it as well.
+    changed = true;
+    while(changed) {
+        changed = false;
+        for(auto i = sources.begin(); i!=sources.end(); i++) {
+            if(!(*i).load) continue;
+            for(auto j = (*i).uses.begin(); j!=(*i).uses.end(); j++) {
+                auto def = definer.find(*j);
+                if(def==definer.end()) continue;
+
+                Source& provider = sources[(*def).second];
+                if(!provider.load && !file_exists(*j + ".rmod")) {
+                    provider.load = true;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    #if DEBUG
+        const char* states[] = {"clean","pending","dirty"};
+        for(auto i = sources.begin(); i!=sources.end(); i++)
+            cout << ".. cache " << (*i).path << " " << states[(*i).state]
+                 << ((*i).load ? " (load)" : "") << endl;
+    #endif
+
+    vector<string> ret;
+    unsigned int ind = 0;
+    for(unsigned int i = 0; i<argv.size(); i++) {
+        if(i!=0 && is_fortran_source(argv[i])) {
+            if(sources[ind++].load) ret.push_back(argv[i]);
+        }else
+            ret.push_back(argv[i]);
+    }
+    return ret;
+}
+
+bool TranslationCache::needs_frontend() const {
+    for(auto i = sources.begin(); i!=sources.end(); i++)
+        if((*i).load) return true;
+    return false;
+}
+
+vector<SgFile*> TranslationCache::select(const vector<SgFile*>& loaded) {
+    map<string,SgFile*> files;
+    for(auto i = loaded.begin(); i!=loaded.end(); i++)
+        files[real_path((*i)->getFileName())] = *i;
+
+    //current interface of every input.
+    vector<string> unloaded_procs;
+    for(auto i = sources.begin(); i!=sources.end(); i++) {
+        auto file = files.find((*i).real);
+        if(file!=files.end()) {
+            (*i).procs = ftc::xf_fn_interfaces((*file).second);
+            (*i).calls = ftc::xf_fn_calls((*file).second);
+        }else
+            unloaded_procs.insert(unloaded_procs.end(), (*i).procs.begin(), (*i).procs.end());
+    }
+    ftc::xf_load_fn_interfaces(unloaded_procs);
+
+    //interface lines of every module, and of every procedure outside of one.
+    map<string,string> interfaces;
+    map<string,string> externals;
+    for(auto i = sources.begin(); i!=sources.end(); i++) {
+        for(auto j = (*i).defines.begin(); j!=(*i).defines.end(); j++)
+            interfaces[*j] = "";
+        for(auto j = (*i).procs.begin(); j!=(*i).procs.end(); j++) {
+            stringstream fields (*j);
+            string tag, module, name;
+            fields >> tag >> module >> name;
+            if(module=="-")
+                 externals[name].append(*j).append("\n");
+            else interfaces[module].append(*j).append("\n");
+        }
+    }
+
+    //fingerprint of a module: hash of its interface lines and the fingerprints of the modules
+    //used by the file defining it, which it may pass on or take PARAMETERs from.
+    fingerprints.clear();
+    for(auto i = interfaces.begin(); i!=interfaces.end(); i++)
+        fingerprint((*i).first, interfaces);
+
+    //fingerprint of an external procedure: hash of its interface line.
+    external_fingerprints.clear();
+    for(auto i = externals.begin(); i!=externals.end(); i++)
+        external_fingerprints[(*i).first] = hash_string((*i).second);
+
+    vector<SgFile*> ret;
+    for(auto i = sources.begin(); i!=sources.end(); i++) {
+        auto file = files.find((*i).real);
+        if(file==files.end()) continue;
+
+        if((*i).state==DIRTY)
+            (*i).translate = true;
+        else if((*i).state==PENDING) {
+            for(auto j = (*i).uses.begin(); j!=(*i).uses.end(); j++) {
+                auto used = (*i).used_fingerprints.find(*j);
+                auto current = fingerprints.find(*j);
+                string fingerprint = current==fingerprints.end() ? "-" : (*current).second;
+                if(used==(*i).used_fingerprints.end() || (*used).second!=fingerprint) {
+                    (*i).translate = true;
+                    break;
+                }
+            }
+            for(auto j = (*i).calls.begin(); j!=(*i).calls.end() && !(*i).translate; j++) {
+                auto called = (*i).called_fingerprints.find(*j);
+                auto current = external_fingerprints.find(*j);
+                string fingerprint = current==external_fingerprints.end() ? "-" : (*current).second;
+                if(called==(*i).called_fingerprints.end() || (*called).second!=fingerprint)
+                    (*i).translate = true;
+            }
+        }
+
+        if((*i).translate) ret.push_back((*file).second);
+    }
+
+    #if DEBUG
+        for(auto i = sources.begin(); i!=sources.end(); i++)
+            cout << ".. cache " << (*i).path << ((*i).translate ? " translate" : " reuse") << endl;
+    #endif
+
+    return ret;
+}
+
+map<string,string> TranslationCache::module_headers() const {
+    map<string,string> ret;
+    for(auto i = sources.begin(); i!=sources.end(); i++) {
+        if((*i).translate) continue;
+        for(auto j = (*i).defines.begin(); j!=(*i).defines.end(); j++)
+            ret[*j] = output(*i, ".h");
+    }
+    return ret;
+}
+
+bool TranslationCache::restore() {
+    bool ok = true;
+    for(auto i = sources.begin(); i!=sources.end(); i++) {
+        if((*i).translate || !(*i).cached) continue;
+
+        if(!copy_file(entry(*i, ".c"), output(*i, ".c")) || !copy_file(entry(*i, ".h"), output(*i, ".h"))) {
+            cout << "ERROR: couldn't restore cached translation of " << (*i).path << endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+void TranslationCache::store(const vector<SgFile*>& translated) {
+    set<string> paths;
+    for(auto i = translated.begin(); i!=translated.end(); i++)
+        paths.insert(real_path((*i)->getFileName()));
+
+    for(auto i = sources.begin(); i!=sources.end(); i++) {
+        if(paths.find((*i).real)==paths.end()) continue;
+
+        if(!copy_file(output(*i, ".c"), entry(*i, ".c")) || !copy_file(output(*i, ".h"), entry(*i, ".h"))) {
+            cout << "WARNING: couldn't cache translation of " << (*i).path << endl;
+            continue;
+        }
+
+        ofstream out (entry(*i, ".entry").c_str(), std::ios::out | std::ios::trunc);
+        out << "ftc-cache 2" << endl;
+        out << "source " << (*i).hash << endl;
+        for(auto j = (*i).uses.begin(); j!=(*i).uses.end(); j++) {
+            auto fingerprint = fingerprints.find(*j);
+            out << "use " << *j << " " << (fingerprint==fingerprints.end() ? string("-") : (*fingerprint).second) << endl;
+        }
+        for(auto j = (*i).calls.begin(); j!=(*i).calls.end(); j++) {
+            auto fingerprint = external_fingerprints.find(*j);
+            out << "call " << *j << " " << (fingerprint==external_fingerprints.end() ? string("-") : (*fingerprint).second) << endl;
+        }
+        for(auto j = (*i).procs.begin(); j!=(*i).procs.end(); j++)
+            out << *j << endl;
+    }
+}
+
+string TranslationCache::fingerprint(const string& module, const map<string,string>& interfaces) {
+    auto done = fingerprints.find(module);
+    if(done!=fingerprints.end()) return (*done).second;
+
+    //modules can't use each other in a cycle, this only guards against malformed input.
+    fingerprints[module] = "-";
+
+    string data;
+    auto lines = interfaces.find(module);
+    if(lines!=interfaces.end()) data = (*lines).second;
+
+    auto def = definer.find(module);
+    if(def!=definer.end()) {
+        const Source& source = sources[(*def).second];
+        for(auto i = source.uses.begin(); i!=source.uses.end(); i++)
+            if(source.defines.find(*i)==source.defines.end())
+                data.append("use ").append(*i).append(" ").append(fingerprint(*i, interfaces)).append("\n");
+    }
+
+    return fingerprints[module] = hash_string(data);
+}
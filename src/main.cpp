@@ -3,9 +3,15 @@
 #include <rose.h>
 #include "printer.hpp"
 #include "translator.hpp"
+#include "parallel.hpp"
+#include "cache.hpp"
+#include "stream.hpp"
+#include "timing.hpp"
 #include "main.hpp"
 #include <map>
 #include <string>
+#include <cstdlib>
+#include <fstream>
 
 using std::cout;
 using std::endl;
@@ -17,7 +23,73 @@ using std::pair;
 using namespace SageBuilder;
 using namespace SageInterface;
 
-int fortran_to_cpp(vector<string> argv);
+int fortran_to_cpp(vector<string> argv, const FtcOptions& options);
+
+//pull ftc's own options out of argv, leaving the rest for rose.
+bool parse_options(vector<string>& argv, FtcOptions& options) {
+    vector<string> rest;
+    for(unsigned int i = 0; i<argv.size(); i++) {
+        string arg = argv[i];
+        
+        if(arg.compare(0,2,"-j")==0 && i!=0) {
+            string count = arg.substr(2);
+            if(count.empty()) {
+                if(i+1==argv.size()) {
+                    cout << "ERROR: -j expects a number of jobs" << endl;
+                    return false;
+                }
+                count = argv[++i];
+            }
+            options.jobs = atoi(count.c_str());
+            if(options.jobs<1) {
+                cout << "ERROR: -j expects a positive number of jobs" << endl;
+                return false;
+            }
+            continue;
+        }
+        
+        if(arg.compare("--stream")==0) {
+            options.stream = true;
+            continue;
+        }
+        if(arg.compare("--no-restrict")==0) {
+            options.no_restrict = true;
+            continue;
+        }
+        if(arg.compare("--copy-scalars")==0) {
+            options.copy_scalars = true;
+            continue;
+        }
+        
+        if(arg.compare("--time-report")==0) {
+            options.time_report = true;
+            continue;
+        }
+        if(arg.compare(0,19,"--time-report-json=")==0) {
+            options.time_report_json = arg.substr(19);
+            continue;
+        }
+        if(arg.compare(0,18,"--time-report-top=")==0) {
+            options.time_report_top = atoi(arg.substr(18).c_str());
+            continue;
+        }
+        
+        if(arg.compare("--cache")==0 || arg.compare(0,8,"--cache=")==0) {
+            if(arg.size()>8)
+                options.cache_dir = arg.substr(8);
+            else if(i+1==argv.size()) {
+                cout << "ERROR: --cache expects a directory" << endl;
+                return false;
+            }else
+                options.cache_dir = argv[++i];
+            continue;
+        }
+        
+        rest.push_back(arg);
+    }
+    argv = rest;
+    return true;
+}
 
 int main(int _argc, char* _argv[]) {
     #if DEBUG
@@ -25,12 +97,33 @@ int main(int _argc, char* _argv[]) {
     #endif
    
     vector<string> argv (_argv,_argv+_argc);
+    FtcOptions options;
+    if(!parse_options(argv, options)) return 1;
+    
     if(argv.size()==1) {
         cout << "nothing to be done." << endl;
         return 0;
     }
     
-    int errc = fortran_to_cpp(argv);
+    time_report.enabled = options.time_report || !options.time_report_json.empty();
+    ftc::xf_options.restrict_args = !options.no_restrict;
+    ftc::xf_options.copy_scalars = options.copy_scalars;
+    PhaseTimer total ("total");
+    
+    int errc = fortran_to_cpp(argv, options);
+    
+    total.stop();
+    if(options.time_report)
+        time_report.print(cout, options.time_report_top);
+    if(!options.time_report_json.empty()) {
+        if(options.time_report_json.compare("-")==0)
+            time_report.print_json(cout, options.time_report_top);
+        else {
+            std::ofstream json (options.time_report_json.c_str());
+            time_report.print_json(json, options.time_report_top);
+        }
+    }
+    
     if(errc!=0) return errc;
     
     return 0;
@@ -58,28 +151,36 @@ bool is_input_file(const SgFile& file, const vector<string>& argv) {
 vector<SgGlobal*> input_globals;
 //
  
-int fortran_to_cpp(vector<string> argv) {
+int fortran_to_cpp(vector<string> argv, const FtcOptions& options) {
     #if DEBUG
         cout << ">> fortran_to_cpp " << argv << endl;
     #endif
+    
+    bool caching = !options.cache_dir.empty();
+    if(options.stream) {
+        if(caching || options.jobs>1) {
+            cout << "ERROR: --stream can't be combined with -j or --cache" << endl;
+            return 1;
+        }
+        return translate_streaming(argv);
+    }
+    
+    TranslationCache cache (options.cache_dir);
+    if(caching) {
+        argv = cache.plan(argv);
+        if(!cache.needs_frontend())
+            return cache.restore() ? 0 : 1;
+    }
 
+    PhaseTimer frontend_timer ("frontend");
     SgProject* proj = frontend(argv);
+    frontend_timer.stop();
     if(proj==NULL) {
         cout << "Cat. Error: Couldn't create SgProject" << endl;
         return 1;
     }
     
-    SgProject* nproj = NULL;
-    int errc = 0;
-    
-    //maps module name to the file in which it was ACTUALLY defined.
-    //as Rose :: SgUseStatement->get_module() refers to a rose generated fortran file
-    //rather than this original file we need. YAY ROSE WE LOVE YOU.
-    map<string, SgFile*> module_map;
-    vector<SgFile*> c_files;
-    
-    //map each file, to the module names it uses.
-    vector<pair<SgGlobal*,string>> use_statements;
+    vector<SgFile*> files;
 
     //bugfix: 13sep: xf_get_fn_decl in translator.cpp cannot find
     //               other fortran files given in arguments
@@ -94,11 +195,45 @@ int fortran_to_cpp(vector<string> argv) {
         assert(gscope!=NULL);
 
 	input_globals.push_back(gscope);
+	files.push_back(&file);
     }
-   
-    for(int i = 0; i<proj->numberOfFiles(); i++) {
-        SgFile& file = proj->get_file(i);
-        if(!is_input_file(file,argv)) continue;
+    ftc::xf_index_fn_decls(input_globals);
+    
+    map<string, string> module_headers;
+    if(caching) {
+        files = cache.select(files);
+        module_headers = cache.module_headers();
+    }
+    
+    int errc = 0;
+    if(options.jobs>1)
+         errc = translate_parallel(files, module_headers, options.jobs);
+    else errc = translate_files(files, module_headers, NULL);
+    
+    if(caching) {
+        if(!cache.restore()) errc = 1;
+        if(errc==0) cache.store(files);
+    }
+    
+    return errc;
+}
+
+int translate_files(const vector<SgFile*>& files, const map<string,string>& module_headers, map<string,string>* defined, bool release) {
+    SgProject* nproj = NULL;
+    int errc = 0;
+    
+    //maps module name to the file in which it was ACTUALLY defined.
+    //as Rose :: SgUseStatement->get_module() refers to a rose generated fortran file
+    //rather than this original file we need. YAY ROSE WE LOVE YOU.
+    map<string, SgFile*> module_map;
+    vector<SgFile*> c_files;
+    vector<string> c_inputs; //fortran file each of c_files was translated from.
+    
+    //map each file, to the module names it uses.
+    vector<pair<SgGlobal*,string>> use_statements;
+
+    for(auto i = files.begin(); i!=files.end(); i++) {
+        SgFile& file = **i;
         
         #if DEBUG
             cout << endl << endl << endl;
@@ -113,12 +248,14 @@ int fortran_to_cpp(vector<string> argv) {
         #endif
         
         SgFile* nfile = NULL;
+        PhaseTimer timer ("xf_file", file.getFileName());
         try {
             nfile = ftc::xf_file(&file, &nproj,  module_map,use_statements);
         }catch(std::string err) {
             cout << "ERROR: " << err << endl;
             errc = 1;
         }
+        timer.stop();
         
         #if DEBUG
             if(nfile!=NULL) {
@@ -128,7 +265,10 @@ int fortran_to_cpp(vector<string> argv) {
                 cout << ".. translation... failed!" << endl;
         #endif
         
-        if(nfile!=NULL) c_files.push_back(nfile);
+        if(nfile!=NULL) {
+            c_files.push_back(nfile);
+            c_inputs.push_back(file.getFileName());
+        }
     }
     
     #if DEBUG
@@ -143,12 +283,19 @@ int fortran_to_cpp(vector<string> argv) {
     for(auto i = use_statements.begin(); i!=use_statements.end(); i++) {
         SgGlobal* c_gscope = (*i).first;
         string  iname = (*i).second;
-        assert(module_map.find(iname)!=module_map.end());
         
-        SgFile* m_file = module_map[iname];
-        string name = m_file->get_unparse_output_filename();
-        name.erase(name.find_last_of('.'));
-        name.append(".h");
+        string name;
+        if(module_map.find(iname)!=module_map.end()) {
+            SgFile* m_file = module_map[iname];
+            name = m_file->get_unparse_output_filename();
+            name.erase(name.find_last_of('.'));
+            name.append(".h");
+        }else {
+            //defined by a file translated by another process (see parallel.cpp).
+            auto m_header = module_headers.find(iname);
+            assert(m_header!=module_headers.end());
+            name = (*m_header).second;
+        }
         
         insertHeader(name.substr(name.find_last_of('/')+1), PreprocessingInfo::after, true, c_gscope);
         #if DEBUG
@@ -157,6 +304,15 @@ int fortran_to_cpp(vector<string> argv) {
         #endif
     }
 
+    if(defined!=NULL) {
+        for(auto i = module_map.begin(); i != module_map.end(); i++) {
+            string name = (*i).second->get_unparse_output_filename();
+            name.erase(name.find_last_of('.'));
+            name.append(".h");
+            (*defined)[(*i).first] = name;
+        }
+    }
+    
     #if DEBUG
         cout << endl << "C translation complete!!!!" << endl;
         cout << "...now to generate header accompaniments >:(" << endl;
@@ -169,12 +325,14 @@ int fortran_to_cpp(vector<string> argv) {
         #endif
     
         SgFile* hfile = NULL;
+        PhaseTimer timer ("xf_gen_header", c_inputs[i - c_files.begin()]);
         try {
             hfile = ftc::xf_gen_header(*i, nproj);
         }catch(std::string err) {
             cout << "ERROR: " << err << endl;
             errc = 1;
         }
+        timer.stop();
         
         #if DEBUG
             if(hfile!=NULL) {
@@ -194,8 +352,16 @@ int fortran_to_cpp(vector<string> argv) {
         insertHeader(path.substr(path.find_last_of('/')+1), PreprocessingInfo::after, true, gscope);
     }
     
-    if(nproj!=NULL)    
+    if(nproj!=NULL) {
+        PhaseTimer timer ("unparse", files.size()==1 ? files[0]->getFileName() : "");
         nproj->unparse();
+    }
+    
+    if(release && nproj!=NULL) {
+        for(auto i = c_files.begin(); i!=c_files.end(); i++)
+            ftc::xf_release_attributes(*i);
+        deleteAST(nproj);
+    }
     
     #if DEBUG
         cout << endl << "..ACTUALLY. finished now!! byebye." << endl << endl;
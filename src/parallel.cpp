@@ -0,0 +1,297 @@
+#include "parallel.hpp"
+#include "main.hpp"
+#include "timing.hpp"
+#include <rose.h>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <map>
+#include <set>
+#include <deque>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+using std::cout;
+using std::endl;
+using std::vector;
+using std::string;
+using std::map;
+using std::set;
+using std::deque;
+using std::pair;
+using std::stringstream;
+
+/*
+    Parallel translation driver.
+
+    Every worker is a fork() of this process taken after the frontend has run, so it has
+    its own copy of the whole fortran project and of the translator's global state; only
+    the module -> header names it needs for include directives have to come from other
+    workers. Those are reported back over a pipe as "module <name> <header>" lines and
+    merged by the coordinator before any file using the module is handed out.
+*/
+
+///_________________________________________________________________________________________________
+///
+
+//modules defined and used by an input file.
+class ModuleScanner : public AstSimpleProcessing {
+public:
+    set<string> defines;
+    set<string> uses;
+
+    void visit(SgNode* n) {
+        if(isSgModuleStatement(n))
+            defines.insert(isSgModuleStatement(n)->get_name().getString());
+        if(isSgUseStatement(n))
+            uses.insert(isSgUseStatement(n)->get_name().getString());
+    }
+};
+
+struct Unit {
+    SgFile* file;
+    int waiting;            //number of files this one uses modules of, not yet translated.
+    vector<int> dependents; //files waiting on this one.
+    bool skipped;           //not translated, as a file it depends on failed.
+};
+
+//mark everything depending on a failed unit as skipped; returns how many were newly marked.
+unsigned int skip_dependents(vector<Unit>& units, int u) {
+    unsigned int ret = 0;
+    for(auto i = units[u].dependents.begin(); i!=units[u].dependents.end(); i++) {
+        if(units[*i].skipped) continue;
+        units[*i].skipped = true;
+        ret += 1 + skip_dependents(units, *i);
+    }
+    return ret;
+}
+
+struct Worker {
+    int unit;
+    int fd;
+    string report;
+};
+
+///_________________________________________________________________________________________________
+///
+
+//translate a single file and report the modules it defined. never returns.
+void run_worker(SgFile* file, const map<string,string>& module_headers, int fd) {
+    //only report what this worker did, not what it inherited.
+    time_report.phases.clear();
+    time_report.nodes.clear();
+    
+    vector<SgFile*> files (1, file);
+    map<string,string> defined;
+    int errc = translate_files(files, module_headers, &defined);
+
+    stringstream report;
+    for(auto i = defined.begin(); i!=defined.end(); i++)
+        report << "module " << (*i).first << " " << (*i).second << "\n";
+    if(time_report.enabled)
+        report << time_report.serialize();
+
+    string out = report.str();
+    size_t done = 0;
+    while(done<out.size()) {
+        ssize_t n = write(fd, out.data()+done, out.size()-done);
+        if(n<0) {
+            if(errno==EINTR) continue;
+            errc = 1;
+            break;
+        }
+        done += n;
+    }
+    close(fd);
+
+    cout.flush();
+    _exit(errc);
+}
+
+//merge a finished worker's report into module_headers (and the time report).
+void merge_report(const string& report, map<string,string>& module_headers) {
+    stringstream in (report);
+    string line;
+    while(getline(in, line)) {
+        if(line.compare(0,7,"module ")!=0) continue;
+
+        line.erase(0,7);
+        size_t split = line.find(' ');
+        if(split==string::npos) continue;
+
+        module_headers[line.substr(0,split)] = line.substr(split+1);
+    }
+    
+    time_report.merge(report);
+}
+
+///_________________________________________________________________________________________________
+///
+
+int translate_parallel(const vector<SgFile*>& files, const map<string,string>& known_headers, int jobs) {
+    #if DEBUG
+        cout << ">> translate_parallel " << files.size() << " files, " << jobs << " jobs" << endl;
+    #endif
+
+    int errc = 0;
+
+    //build module dependency graph between the input files.
+    vector<Unit> units (files.size());
+    vector<set<string>> uses (files.size());
+    map<string, int> definer;
+    for(unsigned int i = 0; i<files.size(); i++) {
+        ModuleScanner scanner;
+        scanner.traverse(files[i], preorder);
+
+        units[i].file = files[i];
+        units[i].waiting = 0;
+        uses[i] = scanner.uses;
+
+        for(auto j = scanner.defines.begin(); j!=scanner.defines.end(); j++) {
+            if(definer.find(*j)!=definer.end()) {
+                cout << "ERROR: module " << *j << " is defined by more than one input file" << endl;
+                return 1;
+            }
+            definer[*j] = i;
+        }
+    }
+    for(unsigned int i = 0; i<units.size(); i++) {
+        set<int> deps;
+        for(auto j = uses[i].begin(); j!=uses[i].end(); j++) {
+            //modules not defined by any input file are left for translate_files to complain about.
+            auto def = definer.find(*j);
+            if(def!=definer.end() && (*def).second!=(int)i)
+                deps.insert((*def).second);
+        }
+        units[i].waiting = deps.size();
+        units[i].skipped = false;
+        for(auto j = deps.begin(); j!=deps.end(); j++)
+            units[*j].dependents.push_back(i);
+    }
+
+    deque<int> ready;
+    for(unsigned int i = 0; i<units.size(); i++)
+        if(units[i].waiting==0) ready.push_back(i);
+
+    //module name -> header, for every module defined by a file translated so far.
+    map<string, string> module_headers (known_headers);
+    map<pid_t, Worker> running;
+    unsigned int finished = 0;
+
+    while(!ready.empty() || !running.empty()) {
+        //hand out as many ready files as there are free workers.
+        while((int)running.size()<jobs && !ready.empty()) {
+            int u = ready.front();
+            ready.pop_front();
+
+            int fds[2];
+            if(pipe(fds)!=0) {
+                cout << "ERROR: couldn't create pipe for translation worker" << endl;
+                errc = 1;
+                break;
+            }
+
+            cout.flush();
+            pid_t pid = fork();
+            if(pid<0) {
+                cout << "ERROR: couldn't fork translation worker" << endl;
+                close(fds[0]);
+                close(fds[1]);
+                errc = 1;
+                break;
+            }
+            if(pid==0) {
+                close(fds[0]);
+                for(auto i = running.begin(); i!=running.end(); i++)
+                    close((*i).second.fd);
+                run_worker(units[u].file, module_headers, fds[1]);
+            }
+
+            #if DEBUG
+                cout << ".. worker " << pid << " translating " << units[u].file->getFileName() << endl;
+            #endif
+
+            close(fds[1]);
+            Worker worker;
+            worker.unit = u;
+            worker.fd = fds[0];
+            running[pid] = worker;
+        }
+        if(running.empty()) break;
+
+        //wait on worker output; a closed pipe means the worker is done.
+        vector<pollfd> polls;
+        vector<pid_t> pids;
+        for(auto i = running.begin(); i!=running.end(); i++) {
+            pollfd p;
+            p.fd = (*i).second.fd;
+            p.events = POLLIN;
+            p.revents = 0;
+            polls.push_back(p);
+            pids.push_back((*i).first);
+        }
+        if(poll(&polls[0], polls.size(), -1)<0) {
+            if(errno==EINTR) continue;
+            cout << "ERROR: poll failed waiting on translation workers" << endl;
+            return 1;
+        }
+
+        for(unsigned int i = 0; i<polls.size(); i++) {
+            if(polls[i].revents==0) continue;
+
+            Worker& worker = running[pids[i]];
+            char buffer[4096];
+            ssize_t n = read(worker.fd, buffer, sizeof(buffer));
+            if(n<0 && errno==EINTR) continue;
+            if(n>0) {
+                worker.report.append(buffer, n);
+                continue;
+            }
+
+            close(worker.fd);
+            int status = 0;
+            while(waitpid(pids[i], &status, 0)<0 && errno==EINTR) {}
+
+            Unit& unit = units[worker.unit];
+            bool failed = !WIFEXITED(status) || WEXITSTATUS(status)!=0;
+            if(failed) {
+                if(!WIFEXITED(status))
+                    cout << "ERROR: translation worker died translating " << unit.file->getFileName() << endl;
+                errc = 1;
+            }
+            merge_report(worker.report, module_headers);
+            finished++;
+
+            //files using its modules can't be translated without its header; rather than
+            //have each of them fail in turn, they are skipped.
+            if(failed) {
+                unsigned int skipped = skip_dependents(units, worker.unit);
+                if(skipped>0)
+                    cout << "ERROR: " << skipped << " file(s) depending on " << unit.file->getFileName()
+                         << " not translated" << endl;
+                finished += skipped;
+            }
+
+            for(auto j = unit.dependents.begin(); j!=unit.dependents.end(); j++)
+                if(--units[*j].waiting==0 && !units[*j].skipped) ready.push_back(*j);
+
+            running.erase(pids[i]);
+        }
+    }
+
+    if(errc==0 && finished!=units.size()) {
+        cout << "ERROR: circular module dependency between input files" << endl;
+        errc = 1;
+    }
+
+    #if DEBUG
+        for(auto i = module_headers.begin(); i!=module_headers.end(); i++)
+            cout << "Module (" << (*i).first << ") header: " << (*i).second << endl;
+    #endif
+
+    return errc;
+}
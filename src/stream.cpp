@@ -0,0 +1,112 @@
+#include "stream.hpp"
+#include "main.hpp"
+#include "printer.hpp"
+#include "translator.hpp"
+#include "cache.hpp"
+#include "timing.hpp"
+#include <rose.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <map>
+#include <set>
+
+using std::cout;
+using std::endl;
+using std::vector;
+using std::string;
+using std::map;
+using std::set;
+
+using namespace SageInterface;
+
+/*
+    Streaming translation driver.
+
+    Instead of parsing every input up front and unparsing everything at the end, the frontend
+    is run on one input file at a time. The file is translated, it and its header are
+    unparsed, then its fortran and C ASTs are deleted. Between files only the interface
+    summaries of translated procedures (the same ones --cache keeps) and the headers of
+    defined modules survive, so peak memory follows the largest file, not the whole program.
+
+    Calls to procedures outside of modules only get their intents right when the callee was
+    in an earlier file. A call to one defined by a later file is an error naming the callee;
+    the files have to be reordered.
+*/
+
+int translate_streaming(const vector<string>& argv) {
+    #if DEBUG
+        cout << ">> translate_streaming " << argv << endl;
+    #endif
+
+    vector<string> flags;
+    vector<string> sources;
+    flags.push_back(argv[0]);
+    for(unsigned int i = 1; i<argv.size(); i++) {
+        if(is_fortran_source(argv[i])) sources.push_back(argv[i]);
+        else flags.push_back(argv[i]);
+    }
+
+    //procedures outside of modules defined by each input, to catch calls to ones not loaded yet.
+    vector<set<string>> procedures (sources.size());
+    for(unsigned int i = 0; i<sources.size(); i++) {
+        string text;
+        set<string> defines, uses;
+        if(read_file(sources[i], text))
+            scan_modules(text, defines, uses, procedures[i]);
+    }
+
+    int errc = 0;
+    
+    //module name -> header, for every module defined by a file translated so far.
+    map<string, string> module_headers;
+    
+    for(auto i = sources.begin(); i!=sources.end(); i++) {
+        set<string> later;
+        for(unsigned int j = i - sources.begin() + 1; j<sources.size(); j++)
+            later.insert(procedures[j].begin(), procedures[j].end());
+        for(unsigned int j = 0; j<=i - sources.begin(); j++)
+            for(auto k = procedures[j].begin(); k!=procedures[j].end(); k++)
+                later.erase(*k);
+        ftc::xf_set_later_fns(later);
+
+        vector<string> file_argv (flags);
+        file_argv.push_back(*i);
+
+        PhaseTimer frontend_timer ("frontend", *i);
+        SgProject* proj = frontend(file_argv);
+        frontend_timer.stop();
+        if(proj==NULL) {
+            cout << "Cat. Error: Couldn't create SgProject for " << *i << endl;
+            return 1;
+        }
+
+        vector<SgFile*> files;
+        vector<SgGlobal*> globals;
+        for(int j = 0; j<proj->numberOfFiles(); j++) {
+            SgFile& file = proj->get_file(j);
+            if(!is_input_file(file,file_argv)) continue;
+
+            ftc::GFinder finder;
+            SgGlobal* gscope = finder.find(&file);
+            assert(gscope!=NULL);
+
+            globals.push_back(gscope);
+            files.push_back(&file);
+        }
+        ftc::xf_index_fn_decls(globals);
+
+        map<string, string> defined;
+        if(translate_files(files, module_headers, &defined, true)!=0)
+            errc = 1;
+        module_headers.insert(defined.begin(), defined.end());
+
+        //later files only see this one through its interface summaries.
+        PhaseTimer release_timer ("release", *i);
+        ftc::xf_release_fn_decls(files);
+        deleteAST(proj);
+        release_timer.stop();
+    }
+
+    return errc;
+}
@@ -0,0 +1,245 @@
+#include "timing.hpp"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <vector>
+#include <map>
+#include <string>
+#include <climits>
+#include <cstdlib>
+#include <time.h>
+#include <sys/resource.h>
+
+using std::endl;
+using std::vector;
+using std::string;
+using std::map;
+using std::pair;
+using std::ostream;
+using std::stringstream;
+
+TimeReport time_report;
+
+///_________________________________________________________________________________________________
+///
+
+double clock_seconds(clockid_t clock) {
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+long peak_rss() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+//phases are keyed by absolute path, however the file was named (command line, rose).
+static string phase_file(const string& file) {
+    char buffer[PATH_MAX];
+    if(file.empty() || realpath(file.c_str(), buffer)==NULL) return file;
+    return string(buffer);
+}
+
+PhaseTimer::PhaseTimer(const string& name, const string& file) {
+    this->name = name;
+    running = time_report.enabled;
+    if(running) {
+        this->file = phase_file(file);
+        wall = clock_seconds(CLOCK_MONOTONIC);
+        cpu = clock_seconds(CLOCK_PROCESS_CPUTIME_ID);
+    }
+}
+
+PhaseTimer::~PhaseTimer() {
+    stop();
+}
+
+void PhaseTimer::stop() {
+    if(!running) return;
+    running = false;
+
+    TimeReport::Phase phase;
+    phase.name = name;
+    phase.file = file;
+    phase.wall = clock_seconds(CLOCK_MONOTONIC) - wall;
+    phase.cpu = clock_seconds(CLOCK_PROCESS_CPUTIME_ID) - cpu;
+    phase.peak_rss = peak_rss();
+    time_report.phases.push_back(phase);
+}
+
+///_________________________________________________________________________________________________
+///
+
+long TimeReport::total_nodes() const {
+    long ret = 0;
+    for(auto i = nodes.begin(); i!=nodes.end(); i++)
+        ret += (*i).second;
+    return ret;
+}
+
+double TimeReport::translate_time() const {
+    double ret = 0;
+    for(auto i = phases.begin(); i!=phases.end(); i++)
+        if((*i).name=="xf_file") ret += (*i).wall;
+    return ret;
+}
+
+bool slower(const pair<string,double>& a, const pair<string,double>& b) {
+    return a.second > b.second;
+}
+
+//files taking the most wall time over all their phases.
+vector<pair<string,double>> TimeReport::slowest_files(int n) const {
+    map<string,double> per_file;
+    for(auto i = phases.begin(); i!=phases.end(); i++)
+        if(!(*i).file.empty()) per_file[(*i).file] += (*i).wall;
+
+    vector<pair<string,double>> ret (per_file.begin(), per_file.end());
+    std::stable_sort(ret.begin(), ret.end(), slower);
+    if((int)ret.size()>n) ret.resize(n);
+    return ret;
+}
+
+void TimeReport::print(ostream& out, int slowest) const {
+    //per phase totals, in order of first appearance.
+    vector<string> order;
+    map<string,Phase> totals;
+    for(auto i = phases.begin(); i!=phases.end(); i++) {
+        if(totals.find((*i).name)==totals.end()) {
+            order.push_back((*i).name);
+            totals[(*i).name] = *i;
+        }else {
+            Phase& total = totals[(*i).name];
+            total.wall += (*i).wall;
+            total.cpu += (*i).cpu;
+            total.peak_rss = std::max(total.peak_rss, (*i).peak_rss);
+        }
+    }
+
+    out << std::fixed << std::setprecision(3);
+    out << "---- ftc time report ----" << endl;
+    out << std::left << std::setw(16) << "phase" << std::right
+        << std::setw(12) << "wall (s)" << std::setw(12) << "cpu (s)" << std::setw(16) << "peak rss (kB)" << endl;
+    for(auto i = order.begin(); i!=order.end(); i++) {
+        const Phase& total = totals[*i];
+        out << std::left << std::setw(16) << total.name << std::right
+            << std::setw(12) << total.wall << std::setw(12) << total.cpu << std::setw(16) << total.peak_rss << endl;
+    }
+
+    auto files = slowest_files(slowest);
+    if(!files.empty()) {
+        out << endl << "slowest files:" << endl;
+        for(auto i = files.begin(); i!=files.end(); i++) {
+            out << std::setw(10) << (*i).second << "  " << (*i).first << endl;
+            for(auto j = phases.begin(); j!=phases.end(); j++)
+                if((*j).file==(*i).first)
+                    out << std::setw(22) << (*j).wall << "  " << (*j).name << endl;
+        }
+    }
+
+    long total = total_nodes();
+    double time = translate_time();
+    out << endl << "translated nodes: " << total;
+    if(time>0) out << " (" << std::setprecision(0) << total/time << " nodes/s)";
+    out << endl;
+    for(auto i = nodes.begin(); i!=nodes.end(); i++)
+        out << std::setw(10) << (*i).second << "  " << (*i).first << endl;
+}
+
+string json_string(const string& s) {
+    stringstream ret;
+    ret << '"';
+    for(unsigned int i = 0; i<s.size(); i++) {
+        char c = s[i];
+        if(c=='"' || c=='\\') ret << '\\' << c;
+        else if((unsigned char)c<0x20) ret << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c << std::dec << std::setfill(' ');
+        else ret << c;
+    }
+    ret << '"';
+    return ret.str();
+}
+
+void TimeReport::print_json(ostream& out, int slowest) const {
+    out << std::fixed << std::setprecision(6);
+    out << "{" << endl;
+
+    out << "  \"phases\": [" << endl;
+    for(auto i = phases.begin(); i!=phases.end(); i++) {
+        out << "    {\"phase\": " << json_string((*i).name)
+            << ", \"file\": " << json_string((*i).file)
+            << ", \"wall\": " << (*i).wall
+            << ", \"cpu\": " << (*i).cpu
+            << ", \"peak_rss_kb\": " << (*i).peak_rss << "}"
+            << (i+1==phases.end() ? "" : ",") << endl;
+    }
+    out << "  ]," << endl;
+
+    auto files = slowest_files(slowest);
+    out << "  \"slowest_files\": [" << endl;
+    for(auto i = files.begin(); i!=files.end(); i++) {
+        out << "    {\"file\": " << json_string((*i).first) << ", \"wall\": " << (*i).second << "}"
+            << (i+1==files.end() ? "" : ",") << endl;
+    }
+    out << "  ]," << endl;
+
+    out << "  \"nodes\": {" << endl;
+    for(auto i = nodes.begin(); i!=nodes.end(); i++) {
+        auto next = i;
+        next++;
+        out << "    " << json_string((*i).first) << ": " << (*i).second
+            << (next==nodes.end() ? "" : ",") << endl;
+    }
+    out << "  }," << endl;
+
+    long total = total_nodes();
+    double time = translate_time();
+    out << "  \"total_nodes\": " << total << "," << endl;
+    out << "  \"nodes_per_sec\": " << (time>0 ? total/time : 0) << endl;
+    out << "}" << endl;
+}
+
+///_________________________________________________________________________________________________
+///
+
+/*
+    one line per phase / node class:
+
+        phase <wall> <cpu> <peak rss> <name> <file>
+        nodes <count> <class>
+*/
+string TimeReport::serialize() const {
+    stringstream out;
+    out << std::setprecision(9);
+    for(auto i = phases.begin(); i!=phases.end(); i++)
+        out << "phase " << (*i).wall << " " << (*i).cpu << " " << (*i).peak_rss << " "
+            << (*i).name << " " << (*i).file << "\n";
+    for(auto i = nodes.begin(); i!=nodes.end(); i++)
+        out << "nodes " << (*i).second << " " << (*i).first << "\n";
+    return out.str();
+}
+
+void TimeReport::merge(const string& report) {
+    stringstream in (report);
+    string line;
+    while(getline(in, line)) {
+        stringstream fields (line);
+        string tag;
+        fields >> tag;
+
+        if(tag=="phase") {
+            Phase phase;
+            fields >> phase.wall >> phase.cpu >> phase.peak_rss >> phase.name;
+            getline(fields, phase.file);
+            if(!phase.file.empty() && phase.file[0]==' ') phase.file.erase(0,1);
+            phases.push_back(phase);
+        }else if(tag=="nodes") {
+            long count;
+            string name;
+            fields >> count >> name;
+            nodes[name] += count;
+        }
+    }
+}
@@ -1,6 +1,8 @@
 #include "translator.hpp"
 #include "rose.h"
 #include "main.hpp"
+#include "timing.hpp"
+#include "traversal.hpp"
 #include <iostream>
 #include <vector>
 #include <string>
@@ -10,6 +12,9 @@
 #include <map>
 #include <cstdlib>
 #include <set>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
 
 using std::cout;
 using std::endl;
@@ -20,6 +25,7 @@ using std::stringstream;
 using std::map;
 using std::set;
 using std::pair;
+using std::unordered_map;
 
 using namespace SageBuilder;
 using namespace SageInterface;
@@ -55,19 +61,23 @@ enum Intent {
     iIN, iOUT, iINOUT, iDEFAULT
 };
 
-class IntentVisitor : public AstSimpleProcessing {
+class IntentVisitor : public ftc::PruningTraversal {
 public:
     vector<SgInitializedName*>* arguments;
     int cnt;
         
     map<string, Intent> result;
+    //intents as declared, before arrays were coerced to iIN in result.
+    map<string, Intent> declared;
+    //arguments that are arrays, and so were coerced to iIN in result.
+    set<string> arrays;
     
     IntentVisitor(vector<SgInitializedName*>* arguments, int cnt) {
         this->arguments = arguments;
         this->cnt = cnt;
     }
      
-    void visit(SgNode* n) {
+    bool preOrderVisit(SgNode* n) {
         #if DEBUG
             cout << "IntentVisitor visit " << n->sage_class_name() << endl;
         #endif
@@ -103,31 +113,43 @@ public:
                     //this is a 'bit' of a hack. there's no need to reference/dereference arrays.
                     //just looks silly, so coerce it to an intent IN type so that it doesn't use
                     //pointers :)                   
-                    if(isSgArrayType(init_name->get_type()))
-                         result[var_name.getString()] = iIN;
-                    else result[var_name.getString()] = intent;
+                    if(isSgArrayType(init_name->get_type())) {
+                        result[var_name.getString()] = iIN;
+                        arrays.insert(var_name.getString());
+                    }else
+                        result[var_name.getString()] = intent;
+                    declared[var_name.getString()] = intent;
                         
                     if((--cnt)==0) {
-                        throw 0; //exit AST traversal.
-                        return;
+                        stop(); //exit AST traversal.
+                        return false;
                     }
                 }
             }
+            
+            //nothing to find inside a declaration.
+            return false;
         }
+        
+        return true;
     }
 };
 
-map<string, Intent> xf_fn_decl_intents(SgFunctionDeclaration* decl) {
-    #if DEBUG
-        cout << "xf_fn_decl_intents(.)" << endl;
-    #endif
-    IntentVisitor ivisitor (&decl->get_args(), decl->get_args().size());
-    try {
-        ivisitor.traverse(decl->get_definition()->get_body(),preorder);
-    }catch(...) {
-    }
-    return ivisitor.result;
-}
+/*
+    Argument intents of a procedure, and which of those arguments are arrays (coerced to iIN).
+    'declared' keeps the intents as written, which only the procedure's own definition needs.
+*/
+struct FnIntents {
+    vector<Intent> intents;
+    vector<bool> arrays;
+    vector<Intent> declared;
+};
+
+//procedure declaration -> intents of its arguments.
+//
+//filled the first time a procedure is needed, be it for a call or its own definition, then
+//shared by every later call in every input file instead of re-scanning the procedure body.
+map<SgFunctionDeclaration*, FnIntents> intent_cache;
 
 /**
     post: order of intents matches original function declaration order of argments.
@@ -140,28 +162,40 @@ map<string, Intent> xf_fn_decl_intents(SgFunctionDeclaration* decl) {
 	    integer :: x
 	end subroutine fun
 
-	xf_fn_decl_ordered_intents([fun_decl]) -> [ [Intent of x], [Intent of y] ]
+	xf_fn_decl_intents([fun_decl]).intents -> [ [Intent of x], [Intent of y] ]
 **/
-vector<Intent> xf_fn_decl_ordered_intents(SgFunctionDeclaration* decl) {
+const FnIntents& xf_fn_decl_intents(SgFunctionDeclaration* decl) {
+    auto cached = intent_cache.find(decl);
+    if(cached!=intent_cache.end())
+        return (*cached).second;
+        
     #if DEBUG
-        cout << "xf_fn_decl_ordered_intents(.)" << endl;
+        cout << "xf_fn_decl_intents(.)" << endl;
     #endif
-    auto intents = xf_fn_decl_intents(decl);
-    vector<Intent> ret;
+    IntentVisitor ivisitor (&decl->get_args(), decl->get_args().size());
+    ivisitor.traverse(decl->get_definition()->get_body());
+    
+    FnIntents& ret = intent_cache[decl];
     
     //iterate original arguments to build ordered list.
     //this enforces the post condition.
     auto& args = decl->get_args();
     for(auto i = args.begin(); i!=args.end(); i++) {
         string arg_name = (*i)->get_name().getString();
-        assert(intents.find(arg_name)!=intents.end());
+        assert(ivisitor.result.find(arg_name)!=ivisitor.result.end());
         
-        ret.push_back(intents[arg_name]);
+        ret.intents.push_back(ivisitor.result[arg_name]);
+        ret.arrays.push_back(ivisitor.arrays.find(arg_name)!=ivisitor.arrays.end());
+        ret.declared.push_back(ivisitor.declared[arg_name]);
     }
     
     return ret;
 }
 
+const vector<Intent>& xf_fn_decl_ordered_intents(SgFunctionDeclaration* decl) {
+    return xf_fn_decl_intents(decl).intents;
+}
+
 ///_________________________________________________________________________________________________
 ///
 
@@ -185,8 +219,11 @@ public:
     //
     // arr(i,j,k) -> arr[(k-lbounds[0])*sizes[0] + (j-lbounds[1])*sizes[1] + (i-lbounds[2])]
     //
+    // |extents| = N, the number of elements along each dimension; NULL for an assumed size '*'.
+    //
     vector<SgExpression*> lbounds;
     vector<SgExpression*> sizes;
+    vector<SgExpression*> extents;
     
     ArrDimAttribute() {}
 };
@@ -194,7 +231,22 @@ public:
 
 namespace ftc {
     SgType* xf_type(SgType* type, bool argpar=false, ArrDimAttribute** arr_attr=NULL);
-    SgExpression* xf_expr(SgExpression* expr, vector<Intent>* intents=NULL);
+    SgExpression* xf_expr(SgExpression* expr, const vector<Intent>* intents=NULL);
+    SgExpression* xf_intrinsic_call(SgFunctionCallExp* fcall);
+    string xf_intrinsic_name(SgFunctionCallExp* fcall);
+    string genForVariableName(const std::string& pre);
+    SgExpression* xf_fold(SgExpression* expr);
+    
+    //scalar operands of an array expression evaluated before its loop nest (fortran operand ->
+    //C temporary), as fortran evaluates them once rather than per element. see xf_hoist_scalars.
+    map<SgExpression*, SgExpression*> hoisted_scalars;
+    
+    //C variable holding the lower bound ("lb") or extent ("n") of a dimension of an allocatable array.
+    string xf_alloc_bound(const string& array, const char* what, int dim) {
+        stringstream ret;
+        ret << "__" << array << "_" << what << dim;
+        return ret.str();
+    }
 }
 
 SgType* ftc::xf_type(SgType* type, bool argpar, ArrDimAttribute** arr_attr) {
@@ -227,27 +279,23 @@ SgType* ftc::xf_type(SgType* type, bool argpar, ArrDimAttribute** arr_attr) {
                 auto* ubound = shape->get_upperBound();
                 if(!isSgAsteriskShapeExp(ubound)) {
                     auto* ubound = xf_expr(shape->get_upperBound());
-                    if(isSgIntVal(lbound) && isSgIntVal(ubound))
-                        subsize = buildIntVal(isSgIntVal(ubound)->get_value()-isSgIntVal(lbound)->get_value()+1);
-                    else if(!isSgIntVal(lbound) || isSgIntVal(lbound)->get_value()!=0)
-                        subsize = buildAddOp(buildIntVal(1),buildSubtractOp(ubound,lbound));
+                    if(isSgIntVal(lbound) && isSgIntVal(lbound)->get_value()==1)
+                        subsize = ubound;
                     else
-                        subsize = buildAddOp(buildIntVal(1),ubound);
+                        subsize = xf_fold(buildAddOp(xf_fold(buildSubtractOp(ubound,deepCopy(lbound))),buildIntVal(1)));
                 }
             }else if(!isSgAsteriskShapeExp(dim)) {
                 lbound = buildIntVal(1);
-                subsize = dim;
+                subsize = xf_expr(dim);
             }else
                 lbound = buildIntVal(1);
             
+            dimattr->extents.push_back(subsize==NULL ? NULL : deepCopy(subsize));
+            
             if(size!=NULL) {
                 dimattr->sizes.push_back(size);
-                if(subsize!=NULL) {
-                    if(isSgIntVal(size) && isSgIntVal(subsize))
-                        size = buildIntVal(isSgIntVal(size)->get_value() * isSgIntVal(subsize)->get_value());
-                    else
-                        size = buildMultiplyOp(size, subsize);
-                }
+                if(subsize!=NULL)
+                    size = xf_fold(buildMultiplyOp(deepCopy(size), subsize));
             }else if(subsize!=NULL)
                 size = subsize;
                     
@@ -266,6 +314,7 @@ SgType* ftc::xf_type(SgType* type, bool argpar, ArrDimAttribute** arr_attr) {
         }
         ret->addNewAttribute("dim", dimattr);*/
         if(arr_attr!=NULL) *arr_attr = dimattr;
+        else delete dimattr;
         
         return ret;
         
@@ -320,6 +369,7 @@ SgType* ftc::xf_type(SgType* type, bool argpar, ArrDimAttribute** arr_attr) {
     if(isSgTypeInt(type)) {
         auto* itype = isSgTypeInt(type);
         auto* kind = itype->get_type_kind();
+        if(isSgVarRefExp(kind)) kind = xf_expr(kind); //kind PARAMETER
         if(kind!=NULL) {
             if(isSgIntVal(kind)) {
                 int value = isSgIntVal(kind)->get_value();
@@ -335,6 +385,7 @@ SgType* ftc::xf_type(SgType* type, bool argpar, ArrDimAttribute** arr_attr) {
     if(isSgTypeFloat(type)) {
         auto* ftype = isSgTypeFloat(type);
         auto* kind = ftype->get_type_kind();
+        if(isSgVarRefExp(kind)) kind = xf_expr(kind); //kind PARAMETER
         if(kind!=NULL) {
             if(isSgIntVal(kind)) {
                 int value = isSgIntVal(kind)->get_value();
@@ -345,6 +396,8 @@ SgType* ftc::xf_type(SgType* type, bool argpar, ArrDimAttribute** arr_attr) {
             }else throw (std::string)"Floating type with non integral kind?";
         }else return buildFloatType();
     }
+    if(isSgTypeDouble(type)) //double precision
+        return buildDoubleType();
     
     if(isSgTypeString(type)) {
         //auto* str = isSgTypeString(type);
@@ -360,6 +413,248 @@ SgType* ftc::xf_type(SgType* type, bool argpar, ArrDimAttribute** arr_attr) {
 ///_________________________________________________________________________________________________
 ///
 
+/**
+
+   Loop invariant array indexing.
+
+   an access a(i,j) inside 'do i' is translated as a[i + __fidx0], with
+   __fidx0 = -lbounds[0] + (j-lbounds[1])*sizes[0] declared just before the outermost loop
+   it doesn't change in, so that the access itself costs a single add.
+
+**/
+
+namespace ftc {
+    //variables assigned in a DO loop, including nested loops: its counter, assignment targets,
+    //variables passed to procedures and variables read into. 'calls' is set if the loop calls
+    //any procedure, which may assign module variables behind our back.
+    struct LoopWrites {
+        set<string> written;
+        bool calls;
+        set<string> counters; //of the DO loops nested in it.
+    };
+    
+    //filled for a whole loop nest at once, when its outermost loop is translated.
+    map<SgFortranDo*, LoopWrites> loop_writes;
+    
+    class LoopWritesCollector : public PruningTraversal {
+        vector<SgFortranDo*> loops;
+        
+        void write(SgExpression* expr) {
+            if(isSgVarRefExp(expr))
+                loop_writes[loops.back()].written.insert(isSgVarRefExp(expr)->get_symbol()->get_name().getString());
+        }
+        
+    protected:
+        bool preOrderVisit(SgNode* n) {
+            if(isSgFortranDo(n)) {
+                auto* init = isSgAssignOp(isSgFortranDo(n)->get_initialization());
+                if(init!=NULL && isSgVarRefExp(init->get_lhs_operand())) {
+                    string counter = isSgVarRefExp(init->get_lhs_operand())->get_symbol()->get_name().getString();
+                    for(auto i = loops.begin(); i!=loops.end(); i++)
+                        loop_writes[*i].counters.insert(counter);
+                }
+                
+                loops.push_back(isSgFortranDo(n));
+                loop_writes[loops.back()].calls = false;
+            }
+            if(loops.empty()) return true;
+            
+            if(isSgAssignOp(n))
+                write(isSgAssignOp(n)->get_lhs_operand());
+            
+            if(isSgFunctionCallExp(n)) {
+                loop_writes[loops.back()].calls = true;
+                auto args = isSgFunctionCallExp(n)->get_args()->get_expressions();
+                for(auto i = args.begin(); i!=args.end(); i++)
+                    write(*i);
+            }
+            
+            if(isSgReadStatement(n)) {
+                auto exprs = isSgReadStatement(n)->get_io_stmt_list()->get_expressions();
+                for(auto i = exprs.begin(); i!=exprs.end(); i++)
+                    write(*i);
+            }
+            
+            //(de)allocation assigns the bounds of allocatable arrays.
+            if(isSgAllocateStatement(n) || isSgDeallocateStatement(n)) {
+                auto* list = isSgAllocateStatement(n) ? isSgAllocateStatement(n)->get_expr_list()
+                                                      : isSgDeallocateStatement(n)->get_expr_list();
+                auto exprs = list->get_expressions();
+                for(auto i = exprs.begin(); i!=exprs.end(); i++) {
+                    auto* var = isSgVarRefExp(isSgPntrArrRefExp(*i) ? isSgPntrArrRefExp(*i)->get_lhs_operand() : *i);
+                    auto* type = var==NULL ? NULL : isSgArrayType(var->get_symbol()->get_type());
+                    if(type==NULL) continue;
+                    
+                    string name = var->get_symbol()->get_name().getString();
+                    for(int d = 0; d<type->get_dim_info()->get_expressions().size(); d++) {
+                        loop_writes[loops.back()].written.insert(xf_alloc_bound(name, "lb", d));
+                        loop_writes[loops.back()].written.insert(xf_alloc_bound(name, "n", d));
+                    }
+                }
+            }
+            
+            return true;
+        }
+        
+        void postOrderVisit(SgNode* n) {
+            if(!isSgFortranDo(n)) return;
+            
+            //whatever is assigned in a nested loop is assigned in this one too.
+            auto& inner = loop_writes[loops.back()];
+            loops.pop_back();
+            if(!loops.empty()) {
+                auto& outer = loop_writes[loops.back()];
+                outer.written.insert(inner.written.begin(), inner.written.end());
+                outer.calls = outer.calls || inner.calls;
+            }
+        }
+    };
+    
+    //DO loops being translated, innermost last.
+    struct LoopContext {
+        SgStatement* loop;          //C for statement; hoisted temporaries are declared before it.
+        const LoopWrites* writes;
+        map<string, string> hoisted; //invariant index expression -> temporary holding it.
+    };
+    vector<LoopContext> loop_stack;
+    
+    //key identifying a C index expression if it has the same value in every iteration of the
+    //loop, else "". only plain integer arithmetic on scalar variables qualifies.
+    string xf_invariant_key(SgExpression* expr, const LoopContext& loop) {
+        switch(expr->variantT()) {
+            case V_SgIntVal: {
+                stringstream ret;
+                ret << isSgIntVal(expr)->get_value();
+                return ret.str();
+            }
+            
+            case V_SgVarRefExp: {
+                auto* sym = isSgVarRefExp(expr)->get_symbol();
+                string name = sym->get_name().getString();
+                if(loop.writes->written.find(name)!=loop.writes->written.end())
+                    return "";
+                
+                //module variables may be assigned by any procedure called in the loop.
+                auto* decl = sym->get_declaration();
+                if(loop.writes->calls && (decl==NULL || isSgGlobal(decl->get_scope())))
+                    return "";
+                
+                return name;
+            }
+            
+            case V_SgPointerDerefExp: {
+                string ret = xf_invariant_key(isSgPointerDerefExp(expr)->get_operand(), loop);
+                return ret.empty() ? ret : "*" + ret;
+            }
+            
+            case V_SgAddOp:
+            case V_SgSubtractOp:
+            case V_SgMultiplyOp: {
+                auto* binop = isSgBinaryOp(expr);
+                string lhs = xf_invariant_key(binop->get_lhs_operand(), loop);
+                string rhs = xf_invariant_key(binop->get_rhs_operand(), loop);
+                if(lhs.empty() || rhs.empty()) return "";
+                
+                const char* op = isSgAddOp(expr) ? "+" : isSgSubtractOp(expr) ? "-" : "*";
+                return "(" + lhs + op + rhs + ")";
+            }
+            
+            default: return "";
+        }
+    }
+    
+    //index arithmetic, folding constants.
+    SgExpression* xf_index_add(SgExpression* lhs, SgExpression* rhs) {
+        if(lhs==NULL) return rhs;
+        if(isSgIntVal(lhs) && isSgIntVal(lhs)->get_value()==0) return rhs;
+        if(isSgIntVal(rhs) && isSgIntVal(rhs)->get_value()==0) return lhs;
+        return xf_fold(buildAddOp(lhs, rhs));
+    }
+    SgExpression* xf_index_sub(SgExpression* lhs, SgExpression* rhs) {
+        if(isSgIntVal(rhs) && isSgIntVal(rhs)->get_value()==0) return lhs;
+        return xf_fold(buildSubtractOp(lhs, rhs));
+    }
+    SgExpression* xf_index_mul(SgExpression* lhs, SgExpression* rhs) {
+        if(rhs==NULL) return lhs;
+        if(isSgIntVal(lhs) && isSgIntVal(lhs)->get_value()==0) return lhs;
+        if(isSgIntVal(rhs) && isSgIntVal(rhs)->get_value()==1) return lhs;
+        if(isSgIntVal(lhs) && isSgIntVal(lhs)->get_value()==1) return rhs;
+        return xf_fold(buildMultiplyOp(lhs, rhs));
+    }
+    
+    //flat index of an array access inside a DO loop: the part varying with the innermost loop
+    //plus a temporary holding the rest. constant offsets of varying indices are moved into the
+    //temporary, so a(i-1,j), a(i,j) and a(i+1,j) each cost one add.
+    //
+    //returns NULL outside of loops, or when there is no non-constant part worth hoisting.
+    SgExpression* xf_hoisted_index(const vector<SgExpression*>& indices, ArrDimAttribute* dimattr) {
+        if(loop_stack.empty()) return NULL;
+        auto& inner = loop_stack.back();
+        
+        SgExpression* varying = NULL;
+        SgExpression* invariant = NULL;
+        for(unsigned int i = 0; i<indices.size(); i++) {
+            //copies, as the caller falls back to the plain index if this gives up.
+            auto* ind = deepCopy(indices[i]);
+            auto* lbound = deepCopy(dimattr->lbounds[i]);
+            auto* stride = i==0 ? NULL : dimattr->sizes[i-1];
+            
+            if(xf_invariant_key(lbound, inner).empty()) return NULL;
+            if(stride!=NULL && xf_invariant_key(stride, inner).empty()) return NULL;
+            
+            if(!xf_invariant_key(ind, inner).empty()) {
+                invariant = xf_index_add(invariant,
+                    xf_index_mul(xf_index_sub(ind, lbound), stride==NULL ? NULL : deepCopy(stride)));
+                continue;
+            }
+            
+            int offset = 0;
+            while(isSgAddOp(ind) || isSgSubtractOp(ind)) {
+                auto* binop = isSgBinaryOp(ind);
+                if(!isSgIntVal(binop->get_rhs_operand())) break;
+                
+                int value = isSgIntVal(binop->get_rhs_operand())->get_value();
+                offset += isSgAddOp(ind) ? value : -value;
+                ind = binop->get_lhs_operand();
+            }
+            
+            varying = xf_index_add(varying, xf_index_mul(ind, stride==NULL ? NULL : deepCopy(stride)));
+            invariant = xf_index_add(invariant,
+                xf_index_mul(xf_index_sub(buildIntVal(offset), lbound), stride==NULL ? NULL : deepCopy(stride)));
+        }
+        if(invariant==NULL || isSgIntVal(invariant)) return NULL;
+        
+        //declare the temporary before the outermost loop it is invariant in.
+        int level = loop_stack.size()-1;
+        while(level>0 && !xf_invariant_key(invariant, loop_stack[level-1]).empty())
+            level--;
+        
+        auto& loop = loop_stack[level];
+        string key = xf_invariant_key(invariant, loop);
+        auto found = loop.hoisted.find(key);
+        
+        string name;
+        if(found!=loop.hoisted.end())
+            name = (*found).second;
+        else {
+            name = genForVariableName("__fidx");
+            auto* decl = buildVariableDeclaration(
+                SgName(name), buildIntType(),
+                buildAssignInitializer(invariant)
+            );
+            insertStatementBefore(loop.loop, decl);
+            loop.hoisted[key] = name;
+        }
+        
+        if(varying==NULL)
+             return buildVarRefExp(SgName(name));
+        else return buildAddOp(varying, buildVarRefExp(SgName(name)));
+    }
+}
+
+///_________________________________________________________________________________________________
+///
+
 namespace ftc {
     
     SgValueExp* xf_value_exp(SgValueExp* val) {
@@ -369,59 +664,171 @@ namespace ftc {
             cout << "xf_value_exp(.)" << endl;
         #endif
         
-        if(isSgBoolValExp(val))
-            return buildIntVal(isSgBoolValExp(val)->get_value()); //NOTE bool->int
+        switch(val->variantT()) {
+            case V_SgBoolValExp:
+                return buildIntVal(isSgBoolValExp(val)->get_value()); //NOTE bool->int
         
-        #define DEF(T) else if(isSg##T##Val(val)) \
-            return build##T##Val(isSg##T##Val(val)->get_value());
+            #define DEF(T) case V_Sg##T##Val: \
+                return build##T##Val(isSg##T##Val(val)->get_value());
         
-        DEF(Int)
-        DEF(Short)
-        DEF(LongInt)
-        DEF(LongLongInt)
+            DEF(Int)
+            DEF(Short)
+            DEF(LongInt)
+            DEF(LongLongInt)
         
-        DEF(Float)
-        DEF(Double)
-        DEF(LongDouble)
-        DEF(String)
+            DEF(Float)
+            DEF(Double)
+            DEF(LongDouble)
+            DEF(String)
         
-        #undef DEF
+            #undef DEF
+            
+            default: break;
+        }
     
         cout << val->sage_class_name() << endl;
         throw (std::string)"Unhandled Value type in tcf::xf_expr::xf_value_exp :: SgValueExp* -> SgValueExp*";
         return NULL;
     }
     
+    ///_____________________________________________________________________________________________
+    ///
+    
+    /*
+        constant folding of translated (C) expressions. operations whose operands are both
+        numeric literals are evaluated, with the type C would give the result: int, long, float
+        or double, the largest of the operands'. integer division truncates, as in fortran.
+        xf_expr replaces PARAMETERs by their values, so expressions of them fold as well.
+    */
+    
+    //rank of a numeric literal's type (0 int, 1 long, 2 float, 3 double) and its value.
+    bool xf_literal(SgExpression* expr, long& ival, double& rval, int& rank) {
+        switch(expr->variantT()) {
+            case V_SgIntVal:     rank = 0; ival = isSgIntVal    (expr)->get_value(); rval = ival; return true;
+            case V_SgLongIntVal: rank = 1; ival = isSgLongIntVal(expr)->get_value(); rval = ival; return true;
+            case V_SgFloatVal:   rank = 2; rval = isSgFloatVal  (expr)->get_value(); ival = 0;    return true;
+            case V_SgDoubleVal:  rank = 3; rval = isSgDoubleVal (expr)->get_value(); ival = 0;    return true;
+            default: return false;
+        }
+    }
+    
+    SgExpression* xf_build_literal(int rank, long ival, double rval) {
+        switch(rank) {
+            case 0:  return buildIntVal((int)ival);
+            case 1:  return buildLongIntVal(ival);
+            case 2:  return buildFloatVal((float)rval);
+            default: return buildDoubleVal(rval);
+        }
+    }
+    
+    //expr evaluated if it is an operation on literals, expr itself otherwise.
+    SgExpression* xf_fold(SgExpression* expr) {
+        long li, ri;
+        double lr, rr;
+        int lk, rk;
+        
+        if(isSgMinusOp(expr)) {
+            if(!xf_literal(isSgMinusOp(expr)->get_operand(), li, lr, lk)) return expr;
+            return xf_build_literal(lk, -li, -lr);
+        }
+        
+        auto* binop = isSgBinaryOp(expr);
+        if(binop==NULL
+        || !xf_literal(binop->get_lhs_operand(), li, lr, lk)
+        || !xf_literal(binop->get_rhs_operand(), ri, rr, rk))
+            return expr;
+        
+        int rank = std::max(lk, rk);
+        bool real = rank>=2;
+        
+        switch(expr->variantT()) {
+            case V_SgAddOp:      return xf_build_literal(rank, li+ri, lr+rr);
+            case V_SgSubtractOp: return xf_build_literal(rank, li-ri, lr-rr);
+            case V_SgMultiplyOp: return xf_build_literal(rank, li*ri, lr*rr);
+            case V_SgDivideOp:
+                //left for the C compiler to diagnose.
+                if(!real && ri==0) return expr;
+                return xf_build_literal(rank, real ? 0 : li/ri, lr/rr);
+            
+            #define DEF(T,OP) case V_Sg##T##Op: \
+                return buildIntVal(real ? lr OP rr : li OP ri);
+            
+            DEF(Equality,      ==)
+            DEF(NotEqual,      !=)
+            DEF(LessThan,      < )
+            DEF(LessOrEqual,   <=)
+            DEF(GreaterThan,   > )
+            DEF(GreaterOrEqual,>=)
+            
+            #undef DEF
+            
+            default: return expr;
+        }
+    }
+    
+    //value of an integer or real PARAMETER, converted to its type; NULL for any other variable,
+    //or a PARAMETER whose value doesn't fold to a literal.
+    SgExpression* xf_parameter(SgVarRefExp* ref) {
+        auto* init_name = ref->get_symbol()->get_declaration();
+        auto* decl = init_name==NULL ? NULL : isSgVariableDeclaration(init_name->get_declaration());
+        if(decl==NULL) return NULL;
+        
+        //rose marks PARAMETERs const.
+        if(!decl->get_declarationModifier().get_typeModifier().get_constVolatileModifier().isConst())
+            return NULL;
+        
+        auto* init = isSgAssignInitializer(init_name->get_initializer());
+        auto* type = init_name->get_type();
+        if(init==NULL || !(isSgTypeInt(type) || isSgTypeFloat(type))) return NULL;
+        
+        long ival;
+        double rval;
+        int rank;
+        auto* value = ftc::xf_expr(init->get_operand());
+        if(!xf_literal(value, ival, rval, rank)) return NULL;
+        
+        auto* ctype = ftc::xf_type(type);
+        if(rank>=2) ival = (long)rval;
+        else        rval = ival;
+        
+        if(isSgTypeInt   (ctype)) return buildIntVal((int)ival);
+        if(isSgTypeLong  (ctype)) return buildLongIntVal(ival);
+        if(isSgTypeFloat (ctype)) return buildFloatVal((float)rval);
+        if(isSgTypeDouble(ctype)) return buildDoubleVal(rval);
+        return NULL;
+    }
+    
     ///_____________________________________________________________________________________________
     ///
 
-    SgExpression* xf_unop_exp(SgUnaryOp* unop) {
+    //nexp, if given, is the already translated operand.
+    SgExpression* xf_unop_exp(SgUnaryOp* unop, SgExpression* nexp=NULL) {
         assert(unop!=NULL);
         
         #if DEBUG
           cout << "xf_unop_exp(.)" << endl;
         #endif
         
-        auto* nexp = ftc::xf_expr(unop->get_operand());
+        if(nexp==NULL)
+            nexp = ftc::xf_expr(unop->get_operand());
         
         SgExpression* ret = NULL;
         
-        #define DEF(T) else if(isSg##T##Op(unop)) \
-            ret = build##T##Op(nexp);
+        switch(unop->variantT()) {
+            #define DEF(T) case V_Sg##T##Op: \
+                ret = build##T##Op(nexp); break;
         
-        if(false) {}
-        DEF(MinusMinus)
-        DEF(PlusPlus)
-        DEF(Not)
-        DEF(BitComplement)
+            DEF(MinusMinus)
+            DEF(PlusPlus)
+            DEF(Not)
+            DEF(BitComplement)
         
-        #undef DEF
+            #undef DEF
         
-        else if(isSgUnaryAddOp(unop)) ret = nexp;
-        else if(isSgMinusOp(unop)) {
-            if     (isSgIntVal(nexp))   ret = buildIntVal(-isSgIntVal(nexp)->get_value());
-            else if(isSgFloatVal(nexp)) ret = buildFloatVal(-isSgFloatVal(nexp)->get_value());
-            else ret = buildMinusOp(nexp);
+            case V_SgUnaryAddOp: ret = nexp; break;
+            case V_SgMinusOp: ret = xf_fold(buildMinusOp(nexp)); break;
+            
+            default: break;
         }
         
         if(ret==NULL) {
@@ -438,105 +845,207 @@ namespace ftc {
     ///_____________________________________________________________________________________________
     ///
     
-    SgExpression* xf_binop_exp(SgBinaryOp* binop) {
-        assert(binop!=NULL);
+    //kind of an integer or real fortran type; 4 when not given.
+    int xf_kind(SgType* type) {
+        auto* kind = type->get_type_kind();
+        if(isSgVarRefExp(kind)) kind = xf_expr(kind);
+        if(kind!=NULL && isSgIntVal(kind))
+             return isSgIntVal(kind)->get_value();
+        else return isSgTypeDouble(type) ? 8 : 4; //double precision, d0 literals.
+    }
+    
+    //cheap and free of side effects, so it can be repeated in an expanded power.
+    bool xf_simple_operand(SgExpression* expr) {
+        if(isSgPointerDerefExp(expr))
+            expr = isSgPointerDerefExp(expr)->get_operand();
+        return isSgVarRefExp(expr) || isSgValueExp(expr);
+    }
+    
+    /*
+        x**n for constant n in [0,4] is expanded into multiplications (and 1/(...) for n in
+        [-4,-1] with real x). otherwise:
         
-        #if DEBUG
-            cout << "xf_binop_exp(.)" << endl;
-        #endif
+            integer**integer -> ftc__ipow, ftc__ipowl for integer(8)
+            real**integer    -> ftc__powi, ftc__powif for real(4)
+            real**real       -> pow, powf for real(4)
+    */
+    SgExpression* xf_power(SgBinaryOp* binop, SgExpression* lexp, SgExpression* rexp) {
+        SgType* ltype = binop->get_lhs_operand()->get_type();
+        SgType* rtype = binop->get_rhs_operand()->get_type();
+        bool integer = ltype->isIntegerType() && rtype->isIntegerType();
         
-        auto* lexp = ftc::xf_expr(binop->get_lhs_operand());
-        auto* rexp = ftc::xf_expr(binop->get_rhs_operand());
+        //kind of the result; the largest of the operands of the result's type.
+        int kind = 4;
+        if(integer || !ltype->isIntegerType()) kind = std::max(kind, xf_kind(ltype));
+        if(integer || !rtype->isIntegerType()) kind = std::max(kind, xf_kind(rtype));
         
-        SgBinaryOp* ret = NULL;
+        //literal operands are evaluated; a negative integer power is left to ftc__ipow.
+        long li, ri;
+        double lr, rr;
+        int lk, rk;
+        if(xf_literal(lexp, li, lr, lk) && xf_literal(rexp, ri, rr, rk)) {
+            int rank = std::max(lk, rk);
+            if(integer && ri>=0) {
+                long value = 1;
+                for(long base = li; ri>0; base *= base) {
+                    if(ri&1) value *= base;
+                    if((ri >>= 1)==0) break;
+                }
+                return xf_build_literal(rank, value, 0);
+            }
+            if(!integer)
+                return xf_build_literal(rank, 0, rk<2 ? std::pow(lr, (int)ri) : std::pow(lr, rr));
+        }
         
-        #define DEF(T) else if(isSg##T##Op(binop)) \
-            ret = build##T##Op(lexp,rexp);
-            
-        if(false) {}
-        DEF(Add)
-        DEF(AndAssign)
-        DEF(And)
-        DEF(Assign)
-        DEF(BitAnd)
-        DEF(BitOr)
-        DEF(BitXor)
-        DEF(DivAssign)
-        DEF(Divide)
-        DEF(Equality)
-        DEF(GreaterOrEqual)
-        DEF(GreaterThan)
-        DEF(LessOrEqual)
-        DEF(LessThan)
-        DEF(MinusAssign)
-        DEF(MultAssign)
-        DEF(Or)
-        DEF(Multiply)
-        DEF(NotEqual)
-        DEF(PlusAssign)
-        DEF(Subtract)
-        DEF(XorAssign)
-   
-        else if(isSgExponentiationOp(binop)) {
-            SgType* type = binop->get_type();
-            
-            #if DEBUG
-                cout << ".. xf_binop_exp::exponentiation" << endl;
-            #endif
+        if(isSgIntVal(rexp) && xf_simple_operand(lexp)) {
+            int n = isSgIntVal(rexp)->get_value();
+            if(n==0) return xf_build_literal(integer ? (kind==8 ? 1 : 0) : (kind==8 ? 3 : 2), 1, 1.0);
             
-            auto* fn_call = buildFunctionCallExp(SgName("pow"),buildDoubleType(),buildExprListExp(lexp,rexp));
-            
-            if(type->isIntegerType())
-                 return buildCastExp(fn_call, buildIntType());
-            else return fn_call;
+            if(std::abs(n)<=4 && (n>0 || !integer)) {
+                SgExpression* ret = lexp;
+                for(int i = 1; i<std::abs(n); i++)
+                    ret = buildMultiplyOp(ret, deepCopy(lexp));
+                
+                if(n>0) return ret;
+                
+                SgExpression* one = kind==4 ? (SgExpression*)buildFloatVal(1.0f) : buildDoubleVal(1.0);
+                return buildDivideOp(one, ret);
+            }
         }
         
-        else if(isSgPntrArrRefExp(binop)) {
-            assert(isSgExprListExp(rexp));
-            
-            auto* arrtype = lexp->get_type();
-            ArrDimAttribute* dimattr = NULL;
+        if(integer || rtype->isIntegerType())
+            includes.insert(pair<string,bool>("ftc_math.h",true));
+        
+        if(integer) {
+            if(kind==8)
+                 return buildFunctionCallExp(SgName("ftc__ipowl"), buildLongType(), buildExprListExp(lexp,rexp));
+            else return buildFunctionCallExp(SgName("ftc__ipow"),  buildIntType(),  buildExprListExp(lexp,rexp));
+        }
+        
+        if(rtype->isIntegerType()) {
+            if(kind==4)
+                 return buildFunctionCallExp(SgName("ftc__powif"), buildFloatType(),  buildExprListExp(lexp,rexp));
+            else return buildFunctionCallExp(SgName("ftc__powi"),  buildDoubleType(), buildExprListExp(lexp,rexp));
+        }
+        
+        if(kind==4)
+             return buildFunctionCallExp(SgName("powf"), buildFloatType(),  buildExprListExp(lexp,rexp));
+        else return buildFunctionCallExp(SgName("pow"),  buildDoubleType(), buildExprListExp(lexp,rexp));
+    }
+    
+    ///_____________________________________________________________________________________________
+    ///
+    
+    //element of array 'arr' (C expression) at fortran indices 'indices' (C expressions).
+    SgExpression* xf_arr_ref(SgExpression* arr, const vector<SgExpression*>& indices) {
+        assert(isSgVarRefExp(arr));
+        auto* decl = isSgVarRefExp(arr)->get_symbol()->get_declaration();
+        assert(decl->attributeExists("dim"));
+        
+        auto* dimattr = static_cast<ArrDimAttribute*>(decl->getAttribute("dim"));
+        
+        SgExpression* index = xf_hoisted_index(indices, dimattr);
+        if(index!=NULL)
+            return buildPntrArrRefExp(arr, index);
+        
+        for(int i = 0; i<indices.size(); i++) {
+            auto* ind = indices[i];
+            auto* lbound = deepCopy(dimattr->lbounds[i]);
             
-            assert(isSgVarRefExp(lexp));
-            auto* lvar = isSgVarRefExp(lexp);
-            auto* decl = lvar->get_symbol()->get_declaration();
-            assert(decl->attributeExists("dim"));
+            //(i+c)-l as i-(l-c)
+            if(isSgIntVal(lbound) && isSgAddOp(ind) && isSgIntVal(isSgAddOp(ind)->get_rhs_operand())) {
+                lbound = buildIntVal(isSgIntVal(lbound)->get_value() - isSgIntVal(isSgAddOp(ind)->get_rhs_operand())->get_value());
+                ind = isSgAddOp(ind)->get_lhs_operand();
+            }
             
-            dimattr = static_cast<ArrDimAttribute*>(decl->getAttribute("dim"));
+            SgExpression* sub_index = NULL;
+            if(isSgIntVal(ind) && isSgIntVal(lbound))
+                sub_index = buildIntVal(isSgIntVal(ind)->get_value() - isSgIntVal(lbound)->get_value());
+            else if(!isSgIntVal(lbound) || isSgIntVal(lbound)->get_value()!=0)
+                sub_index = buildSubtractOp(ind,lbound);
+            else
+                sub_index = ind;
             
-            auto indices = isSgExprListExp(rexp)->get_expressions();
-            SgExpression* index = NULL;
-            for(int i = 0; i<indices.size(); i++) {
-                auto* ind = indices[i];
-                auto* lbound = dimattr->lbounds[i];
+            if(i!=0) {
+                auto* size = deepCopy(dimattr->sizes[i-1]);
                 
-                SgExpression* sub_index = NULL;
-                if(isSgIntVal(ind) && isSgIntVal(lbound))
-                    sub_index = buildIntVal(isSgIntVal(ind)->get_value() - isSgIntVal(lbound)->get_value());
-                else if(!isSgIntVal(lbound) || isSgIntVal(lbound)->get_value()!=0)
-                    sub_index = buildSubtractOp(ind,lbound);
-                else
-                    sub_index = ind;
+                if(isSgIntVal(size) && isSgIntVal(sub_index))
+                    sub_index = buildIntVal(isSgIntVal(sub_index)->get_value() * isSgIntVal(size)->get_value());
+                else if(!isSgIntVal(size) || isSgIntVal(size)->get_value()!=1)
+                    sub_index = buildMultiplyOp(sub_index, size);
+            }
+            
+            if(index==NULL) index = sub_index;
+            else if(isSgIntVal(index) && isSgIntVal(sub_index))
+                index = buildIntVal(isSgIntVal(index)->get_value() + isSgIntVal(sub_index)->get_value());
+            else if(isSgIntVal(index) && isSgIntVal(index)->get_value()==0)
+                index = sub_index;
+            else if(!isSgIntVal(sub_index) || isSgIntVal(sub_index)->get_value()!=0)
+                index = buildAddOp(index,sub_index);
+        }
+        
+        return buildPntrArrRefExp(arr, index);
+    }
+    
+    ///_____________________________________________________________________________________________
+    ///
+    
+    //lexp and rexp, if given, are the already translated operands.
+    SgExpression* xf_binop_exp(SgBinaryOp* binop, SgExpression* lexp=NULL, SgExpression* rexp=NULL) {
+        assert(binop!=NULL);
+        
+        #if DEBUG
+            cout << "xf_binop_exp(.)" << endl;
+        #endif
+        
+        if(lexp==NULL) lexp = ftc::xf_expr(binop->get_lhs_operand());
+        if(rexp==NULL) rexp = ftc::xf_expr(binop->get_rhs_operand());
+        
+        SgBinaryOp* ret = NULL;
+        
+        switch(binop->variantT()) {
+            #define DEF(T) case V_Sg##T##Op: \
+                ret = build##T##Op(lexp,rexp); break;
                 
-                if(i!=0) {
-                    auto* size = dimattr->sizes[i-1];
-                    
-                    if(isSgIntVal(size) && isSgIntVal(sub_index))
-                        sub_index = buildIntVal(isSgIntVal(sub_index)->get_value() * isSgIntVal(size)->get_value());
-                    else if(!isSgIntVal(size) || isSgIntVal(size)->get_value()!=1)
-                        sub_index = buildMultiplyOp(sub_index, size);
-                }
+            DEF(Add)
+            DEF(AndAssign)
+            DEF(And)
+            DEF(Assign)
+            DEF(BitAnd)
+            DEF(BitOr)
+            DEF(BitXor)
+            DEF(DivAssign)
+            DEF(Divide)
+            DEF(Equality)
+            DEF(GreaterOrEqual)
+            DEF(GreaterThan)
+            DEF(LessOrEqual)
+            DEF(LessThan)
+            DEF(MinusAssign)
+            DEF(MultAssign)
+            DEF(Or)
+            DEF(Multiply)
+            DEF(NotEqual)
+            DEF(PlusAssign)
+            DEF(Subtract)
+            DEF(XorAssign)
+            
+            #undef DEF
+       
+            case V_SgExponentiationOp: {
+                #if DEBUG
+                    cout << ".. xf_binop_exp::exponentiation" << endl;
+                #endif
                 
-                if(index==NULL) index = sub_index;
-                else if(isSgIntVal(index) && isSgIntVal(sub_index))
-                    index = buildIntVal(isSgIntVal(index)->get_value() + isSgIntVal(sub_index)->get_value());
-                else if(isSgIntVal(index) && isSgIntVal(index)->get_value()==0)
-                    index = sub_index;
-                else if(!isSgIntVal(sub_index) || isSgIntVal(sub_index)->get_value()!=0)
-                    index = buildAddOp(index,sub_index);
+                return xf_power(binop, lexp, rexp);
+            }
+            
+            case V_SgPntrArrRefExp: {
+                assert(isSgExprListExp(rexp));
+                return xf_arr_ref(lexp, isSgExprListExp(rexp)->get_expressions());
             }
             
-            return buildPntrArrRefExp(lexp, index);
+            default: break;
         }
         
         /*else if(isSgPntrArrRefExp(binop)) {
@@ -564,14 +1073,12 @@ namespace ftc {
             
             return lhs;
         }*/
-            
-        #undef DEF
         
         if(ret==NULL) {
             cout << binop->sage_class_name() << endl;
             throw (std::string)"Unhandled BinaryOp type in tcf::xf_expr::xf_binop_exp :: SgBinaryOp* -> SgBinaryOp*";
         } else
-            return ret;
+            return xf_fold(ret);
     }
 }
 
@@ -579,284 +1086,477 @@ namespace ftc {
 ///
 
 namespace ftc {
-    class FFinder : public AstSimpleProcessing {
-        string name;
+    //name -> FORTRAN procedure declaration for every procedure in the input files,
+    //including those inside modules and CONTAINS sections.
+    //
+    //built once by xf_index_fn_decls so that call sites don't each have to search
+    //every input file for the declaration.
+    unordered_map<string, SgFunctionDeclaration*> fn_index;
+
+    class FnIndexer : public AstSimpleProcessing {
     public:
-        SgFunctionDeclaration* result;
-    
-        FFinder(const string& name) {
-            this->name = name;
-            result = NULL;
-        }
-        
         void visit(SgNode* n) {
             if(isSgFunctionDeclaration(n)) {
                 auto* decl = isSgFunctionDeclaration(n);
-                if(decl->get_name().getString().compare(name)==0) {
-                    result = isSgFunctionDeclaration(n);
-                    throw 0; //exit AST traversal.
-                }
+                
+                //first declaration found wins, same as the order files were given in.
+                fn_index.insert(pair<string,SgFunctionDeclaration*>(decl->get_name().getString(), decl));
             }
         }
     };
+    
+    void xf_index_fn_decls(const vector<SgGlobal*>& globals) {
+        #if DEBUG
+            cout << "xf_index_fn_decls(.)" << endl;
+        #endif
+        
+        FnIndexer indexer;
+        for(auto i = globals.begin(); i!=globals.end(); i++)
+            indexer.traverse(*i, preorder);
+            
+        #if DEBUG
+            cout << ".. indexed " << fn_index.size() << " procedures" << endl;
+        #endif
+    }
 
     SgFunctionDeclaration* xf_get_fn_decl(const string& name) {
-        FFinder finder (name);
-        try {
-            for(auto i = input_globals.begin(); i!=input_globals.end(); i++)
-	            finder.traverse(*i, preorder);
-        }catch(...) {
-        }
-        return finder.result;
+        auto i = fn_index.find(name);
+        if(i!=fn_index.end())
+             return (*i).second;
+        else return NULL;
     }
     
-    //used (FOR THE MOMENT!) to generate unique FOR loop variables.
-    //and now, perhaps slightly confusingly; also for argument temp. variables
-    int FOR_VARIABLE_NAME = 0;
-    string genForVariableName(const std::string& pre) {
-        stringstream ret;
-        ret << pre;
-        ret << FOR_VARIABLE_NAME;
-        FOR_VARIABLE_NAME++;
-        return ret.str();
+    //procedure name -> intents, for procedures whose fortran source isn't part of this run
+    //(eg. files whose translation was reused from the cache). only used when the index has
+    //no declaration for the name.
+    map<string, FnIntents> fn_interfaces;
+    
+    //intents of the named procedure's arguments, or NULL if it is not a known procedure.
+    const vector<Intent>* xf_get_fn_intents(const string& name) {
+        auto* decl = xf_get_fn_decl(name);
+        if(decl!=NULL)
+            return &xf_fn_decl_ordered_intents(decl);
+        
+        auto i = fn_interfaces.find(name);
+        if(i!=fn_interfaces.end())
+            return &(*i).second.intents;
+        
+        return NULL;
     }
-}
-
-//intents field used for translating function call argument lists correctly.
-//
-//IMPORTANT: this is NOT a pure function. IN the case that additional var stores are required
-//           for function calls, this method WILL inject those declarations to the current scope.
-SgExpression* ftc::xf_expr(SgExpression* expr, vector<Intent>* intents) {
-    assert(expr!=NULL);
     
-    #if DEBUG
-        cout << "xf_expr(.)" << endl;
-    #endif
+    //procedures outside of modules defined by input files not yet loaded (--stream). calls to
+    //them can't get their intents right, so they are errors rather than treated as intrinsics.
+    set<string> later_fns;
     
-    if(isSgVarRefExp(expr)) {
-        auto* ref = isSgVarRefExp(expr);
-        #if DEBUG
-            cout << "xf_expr::var_exp" << endl;
-        #endif
-        auto* sym = lookupVariableSymbolInParentScopes(ref->get_symbol()->get_name());
-        if(sym==NULL) {
-            #if DEBUG
-                cout << " NO C-SYMBOL FOUND!! " << endl << " !! " << endl;
-            #endif
-            return buildVarRefExp(ref->get_symbol()->get_name());
-        }else {
-            auto* type = sym->get_type();
-            auto* var = buildVarRefExp(sym->get_name());
-            
-            if(isSgPointerType(type)) {
-                #if DEBUG
-                    cout << ".. pointer type!" << endl;
-                #endif
+    void xf_set_later_fns(const set<string>& names) {
+        later_fns = names;
+    }
     
-                //an array in disguise            
-                if(var->get_symbol()->get_declaration()->attributeExists("dim"))
-                    return var;
-                else
-                    return buildPointerDerefExp(var);
-            }else
-                return var;
+    bool xf_is_later_fn(const string& name) {
+        string lower = name;
+        std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+        return later_fns.find(lower)!=later_fns.end();
+    }
+    
+    //intent(in) array arguments point to const (see xf_fn_decl). passed on to a procedure whose
+    //dummy isn't declared intent(in), or whose declaration isn't loaded, the const is cast away.
+    SgExprListExp* xf_unconst_args(const string& fn, SgExprListExp* args) {
+        auto* decl = xf_get_fn_decl(fn);
+        vector<SgExpression*> exprs = args->get_expressions();
+        
+        bool changed = false;
+        for(unsigned int k = 0; k<exprs.size(); k++) {
+            if(decl!=NULL && k<xf_fn_decl_intents(decl).declared.size() && xf_fn_decl_intents(decl).declared[k]==iIN)
+                continue;
+            
+            auto* ptr = isSgPointerType(exprs[k]->get_type()->stripType(SgType::STRIP_MODIFIER_TYPE));
+            if(ptr==NULL || !isSgModifierType(ptr->get_base_type())) continue;
+            
+            auto* base = ptr->get_base_type()->stripType(SgType::STRIP_MODIFIER_TYPE);
+            exprs[k] = buildCastExp(exprs[k], buildPointerType(base));
+            changed = true;
         }
+        return changed ? buildExprListExp(exprs) : args;
     }
     
-    if(isSgValueExp(expr)) {
-        auto* val = isSgValueExp(expr);
-        return xf_value_exp(val);
+    //collects a one line summary of every procedure in a file:
+    //
+    //    proc <module or -> <name> <intent of arg 1>[a] <intent of arg 2>[a] ...
+    //
+    //with 'a' marking an array argument; and of every declaration in the specification part
+    //of a module, as users of the module depend on its PARAMETER values (folded into them)
+    //and on the types and extents of its variables:
+    //
+    //    decl <module> <declaration>
+    class InterfaceCollector : public AstPrePostProcessing {
+        vector<string> modules;
+        int procs; //depth of procedure nesting.
+    public:
+        vector<string> lines;
+        
+        InterfaceCollector() : procs(0) {}
+    
+        void preOrderVisit(SgNode* n) {
+            if(isSgModuleStatement(n))
+                modules.push_back(isSgModuleStatement(n)->get_name().getString());
+            
+            if(!modules.empty() && procs==0
+            && (isSgVariableDeclaration(n) || isSgAttributeSpecificationStatement(n))) {
+                string decl = isSgDeclarationStatement(n)->unparseToString();
+                for(unsigned int i = 0; i<decl.size(); i++)
+                    if(decl[i]=='\n' || decl[i]=='\r') decl[i] = ' ';
+                lines.push_back("decl " + modules.back() + " " + decl);
+            }
+            
+            if(isSgProcedureHeaderStatement(n)) {
+                procs++;
+                
+                auto* decl = isSgProcedureHeaderStatement(n);
+                if(decl->get_definition()==NULL) return;
+                
+                auto& intents = xf_fn_decl_intents(decl);
+                stringstream line;
+                line << "proc " << (modules.empty() ? string("-") : modules.back())
+                     << " " << decl->get_name().getString();
+                for(unsigned int i = 0; i<intents.intents.size(); i++)
+                    line << " " << (int)intents.intents[i] << (intents.arrays[i] ? "a" : "");
+                lines.push_back(line.str());
+            }
+        }
+        void postOrderVisit(SgNode* n) {
+            if(isSgModuleStatement(n))
+                modules.pop_back();
+            if(isSgProcedureHeaderStatement(n))
+                procs--;
+        }
+    };
+    
+    vector<string> xf_fn_interfaces(SgFile* file) {
+        InterfaceCollector collector;
+        collector.traverse(file);
+        return collector.lines;
     }
     
-    if(isSgUnaryOp(expr)) {
-        auto* unop = isSgUnaryOp(expr);
-        return xf_unop_exp(unop);
+    //names of the procedures called in a file.
+    class CallCollector : public AstSimpleProcessing {
+    public:
+        set<string> names;
+        
+        void visit(SgNode* n) {
+            auto* fcall = isSgFunctionCallExp(n);
+            if(fcall!=NULL && isSgFunctionRefExp(fcall->get_function()))
+                names.insert(isSgFunctionRefExp(fcall->get_function())->get_symbol()->get_name().getString());
+        }
+    };
+    
+    vector<string> xf_fn_calls(SgFile* file) {
+        CallCollector collector;
+        collector.traverse(file, preorder);
+        return vector<string>(collector.names.begin(), collector.names.end());
     }
     
-    if(isSgBinaryOp(expr)) {
-        auto* binop = isSgBinaryOp(expr);
-        return xf_binop_exp(binop);
+    void xf_load_fn_interfaces(const vector<string>& lines) {
+        for(auto i = lines.begin(); i!=lines.end(); i++) {
+            stringstream in (*i);
+            string tag, module, name, arg;
+            in >> tag >> module >> name;
+            if(tag.compare("proc")!=0) continue;
+            
+            FnIntents intents;
+            while(in >> arg) {
+                intents.intents.push_back((Intent)atoi(arg.c_str()));
+                intents.arrays.push_back(arg[arg.size()-1]=='a');
+            }
+            fn_interfaces[name] = intents;
+        }
+    }
+    
+    void xf_release_fn_decls(const vector<SgFile*>& files) {
+        for(auto i = files.begin(); i!=files.end(); i++)
+            xf_load_fn_interfaces(xf_fn_interfaces(*i));
+        
+        fn_index.clear();
+        intent_cache.clear();
+    }
+    
+    //used (FOR THE MOMENT!) to generate unique FOR loop variables.
+    //and now, perhaps slightly confusingly; also for argument temp. variables
+    int FOR_VARIABLE_NAME = 0;
+    string genForVariableName(const std::string& pre) {
+        stringstream ret;
+        ret << pre;
+        ret << FOR_VARIABLE_NAME;
+        FOR_VARIABLE_NAME++;
+        return ret.str();
     }
+}
 
-    //ASSUMPTION: Fortran doesn't have function pointers (i think). so apart from function calls
-    //which are handled seperately below, this will only ever be for assignment/use of a function 
-    //return value.
-    if(isSgFunctionRefExp(expr)) {
-        #if DEBUG
-            cout << "xf_expr::fun_ref_exp (return value)" << endl;
-        #endif
-        return buildVarRefExp(SgName("__retv"));
+//intents field used for translating function call argument lists correctly.
+//
+//IMPORTANT: this is NOT a pure function. IN the case that additional var stores are required
+//           for function calls, this method WILL inject those declarations to the current scope.
+SgExpression* ftc::xf_expr(SgExpression* expr, const vector<Intent>* intents) {
+    assert(expr!=NULL);
+    time_report.count(expr);
+    
+    if(!hoisted_scalars.empty()) {
+        auto hoisted = hoisted_scalars.find(expr);
+        if(hoisted!=hoisted_scalars.end())
+            return deepCopy((*hoisted).second);
     }
     
-    //ASSUMPTION: Fortran doesn't have function pointers, nor arrays of functions (i think).
-    //so things like fn[i]() is not possible, and the expression supplying the function to call
-    //will only ever be an SgFunctionRefExp!
-    if(isSgFunctionCallExp(expr)) {
-        auto* fcall = isSgFunctionCallExp(expr);
-        #if DEBUG
-            cout << "xf_expr::fun_call_exp" << endl;
-        #endif
+    #if DEBUG
+        cout << "xf_expr(.)" << endl;
+    #endif
+    
+    switch(expr->variantT()) {
+        case V_SgVarRefExp: {
+            auto* ref = isSgVarRefExp(expr);
+            #if DEBUG
+                cout << "xf_expr::var_exp" << endl;
+            #endif
+            //PARAMETERs by value, so their uses fold.
+            auto* value = xf_parameter(ref);
+            if(value!=NULL) return value;
+            
+            auto* sym = lookupVariableSymbolInParentScopes(ref->get_symbol()->get_name());
+            if(sym==NULL) {
+                #if DEBUG
+                    cout << " NO C-SYMBOL FOUND!! " << endl << " !! " << endl;
+                #endif
+                return buildVarRefExp(ref->get_symbol()->get_name());
+            }else {
+                //look through restrict/const on arguments.
+                auto* type = sym->get_type()->stripType(SgType::STRIP_MODIFIER_TYPE);
+                auto* var = buildVarRefExp(sym->get_name());
+                
+                if(isSgPointerType(type)) {
+                    #if DEBUG
+                        cout << ".. pointer type!" << endl;
+                    #endif
         
-        auto* fexp = fcall->get_function();
-        assert(isSgFunctionRefExp(fexp));
+                    //an array in disguise            
+                    if(var->get_symbol()->get_declaration()->attributeExists("dim"))
+                        return var;
+                    else
+                        return buildPointerDerefExp(var);
+                }else
+                    return var;
+            }
+        }
         
-        auto* fsym = isSgFunctionRefExp(fexp)->get_symbol();
-        SgName fn_name = fsym->get_name();
+        //ASSUMPTION: Fortran doesn't have function pointers (i think). so apart from function calls
+        //which are handled seperately below, this will only ever be for assignment/use of a function 
+        //return value.
+        case V_SgFunctionRefExp: {
+            #if DEBUG
+                cout << "xf_expr::fun_ref_exp (return value)" << endl;
+            #endif
+            return buildVarRefExp(SgName("__retv"));
+        }
         
-        //find the FORTRAN function declaration. the C declaration may not exist yet!
-        //
-        //I tried doing this via lookupFunctionSymbolInParentScopes(getScope(expr))
-        //but it doesn't work! so this will do...
-        auto* fort_decl = xf_get_fn_decl(fn_name.getString());
-        SgExprListExp* fn_args = NULL;
-        if(fort_decl!=NULL) {
-            auto intents = xf_fn_decl_ordered_intents(fort_decl);
-            fn_args = isSgExprListExp(xf_expr(fcall->get_args(), &intents));
-        }else {
-            string fn = fn_name.getString();
-            fn_args = isSgExprListExp(xf_expr(fcall->get_args()));
-            
-            if(fn.compare("abs")==0) {
-                assert(fn_args->get_expressions().size()==1);
-                auto* arg = fn_args->get_expressions().front();
-                if(isSgTypeInt(arg->get_type())) {}
-                else fn_name = "fabs"; //redirect.
-            }
+        //ASSUMPTION: Fortran doesn't have function pointers, nor arrays of functions (i think).
+        //so things like fn[i]() is not possible, and the expression supplying the function to call
+        //will only ever be an SgFunctionRefExp!
+        case V_SgFunctionCallExp: {
+            auto* fcall = isSgFunctionCallExp(expr);
+            #if DEBUG
+                cout << "xf_expr::fun_call_exp" << endl;
+            #endif
             
-            if(fn.compare("int")==0 || fn.compare("logical")==0 || fn.compare("ichar")==0) {
-                assert(fn_args->get_expressions().size()==1);
-                auto* arg = fn_args->get_expressions().front();
-                
-                return buildCastExp(arg, buildIntType());
-            }                
+            auto* fexp = fcall->get_function();
+            assert(isSgFunctionRefExp(fexp));
             
-            if(fn.compare("real")==0) {
-                assert(fn_args->get_expressions().size()==1);
-                auto* arg = fn_args->get_expressions().front();
-                
-                return buildCastExp(arg, buildDoubleType());
-            }
+            auto* fsym = isSgFunctionRefExp(fexp)->get_symbol();
+            SgName fn_name = fsym->get_name();
             
-            if(fn.compare("get_environment_variable")==0) {
-                auto args = fn_args->get_expressions();
-                assert(args.size()==2);
+            //find the FORTRAN function declaration. the C declaration may not exist yet!
+            //
+            //I tried doing this via lookupFunctionSymbolInParentScopes(getScope(expr))
+            //but it doesn't work! so this will do...
+            auto* fn_intents = xf_get_fn_intents(fn_name.getString());
+            if(fn_intents==NULL && xf_is_later_fn(fn_name.getString())) {
+                cout << fn_name.getString() << endl;
+                throw (string)"Call to a procedure defined by a later input file (--stream needs callees first) in xf_expr";
+            }
+            SgExprListExp* fn_args = NULL;
+            if(fn_intents!=NULL) {
+                fn_args = isSgExprListExp(xf_expr(fcall->get_args(), fn_intents));
+                fn_args = xf_unconst_args(fn_name.getString(), fn_args);
+            }else {
+                string fn = fn_name.getString();
+                if(!xf_intrinsic_name(fcall).empty())
+                    return xf_intrinsic_call(fcall);
                 
-                includes.insert(pair<string,bool>("stdlib.h",true));
+                fn_args = isSgExprListExp(xf_expr(fcall->get_args()));
                 
-                vector<SgExpression*> ret_args;
-                ret_args.push_back(args[0]);
-                return buildAssignOp(
-                    args[1],
-                    buildFunctionCallExp(
-                        buildFunctionRefExp("getenv"),
-                        buildExprListExp(ret_args)
-                    )
-                );
+                if(fn.compare("abs")==0) {
+                    assert(fn_args->get_expressions().size()==1);
+                    auto* arg = fn_args->get_expressions().front();
+                    if(isSgTypeInt(arg->get_type())) {}
+                    else fn_name = "fabs"; //redirect.
+                }
+                
+                if(fn.compare("int")==0 || fn.compare("logical")==0 || fn.compare("ichar")==0) {
+                    assert(fn_args->get_expressions().size()==1);
+                    auto* arg = fn_args->get_expressions().front();
+                    
+                    return buildCastExp(arg, buildIntType());
+                }                
+                
+                if(fn.compare("real")==0) {
+                    assert(fn_args->get_expressions().size()==1);
+                    auto* arg = fn_args->get_expressions().front();
+                    
+                    return buildCastExp(arg, buildDoubleType());
+                }
+                
+                if(fn.compare("allocated")==0) {
+                    assert(fn_args->get_expressions().size()==1);
+                    auto* arg = fn_args->get_expressions().front();
+                    
+                    return buildNotEqualOp(arg, buildIntVal(0));
+                }
+                
+                if(fn.compare("get_environment_variable")==0) {
+                    auto args = fn_args->get_expressions();
+                    assert(args.size()==2);
+                    
+                    includes.insert(pair<string,bool>("stdlib.h",true));
+                    
+                    vector<SgExpression*> ret_args;
+                    ret_args.push_back(args[0]);
+                    return buildAssignOp(
+                        args[1],
+                        buildFunctionCallExp(
+                            buildFunctionRefExp("getenv"),
+                            buildExprListExp(ret_args)
+                        )
+                    );
+                }
             }
+            return buildFunctionCallExp(
+                buildFunctionRefExp(fn_name),
+                isSgExprListExp(fn_args)
+            );
         }
-        return buildFunctionCallExp(
-            buildFunctionRefExp(fn_name),
-            isSgExprListExp(fn_args)
-        );
-    }
-    
-    if(isSgExprListExp(expr)) {
-        auto exprs = isSgExprListExp(expr)->get_expressions();
-        #if DEBUG
-            cout << "xf_expr::expr_list" << endl;
-        #endif
-        vector<SgExpression*> ret_exprs;
         
-        vector<SgExpression*> texprs;
-        vector<bool> pointer_arg;
-        bool any = false;
-        //first determine if any arguments require a new variable for the function call
-        //in this case, we should pre-calculate ALL arguments to keep order of execution
-        //well defined in the face of possible side-effects.
+        case V_SgExprListExp: {
+            auto exprs = isSgExprListExp(expr)->get_expressions();
+            #if DEBUG
+                cout << "xf_expr::expr_list" << endl;
+            #endif
+            vector<SgExpression*> ret_exprs;
+            
+            vector<SgExpression*> texprs;
+            vector<bool> pointer_arg;
+            bool any = false;
+            //first determine if any arguments require a new variable for the function call
+            //in this case, we should pre-calculate ALL arguments to keep order of execution
+            //well defined in the face of possible side-effects.
 
-        int ind = 0;
-        for(auto i = exprs.begin(); i!=exprs.end(); i++) {
-            auto* ex = xf_expr(*i);
-            texprs.push_back(ex); //only want to call xf_expr on each expression once
-            //as this is an unpure function and may generate variable declarations for temporaries.
-            
-            bool parg = false;
-            if(intents!=NULL) {
-                auto intent = (*intents)[ind++];
-                bool ref = false;
+            int ind = 0;
+            for(auto i = exprs.begin(); i!=exprs.end(); i++) {
+                auto* ex = xf_expr(*i);
+                texprs.push_back(ex); //only want to call xf_expr on each expression once
+                //as this is an unpure function and may generate variable declarations for temporaries.
                 
-                switch(intent) {
-                    case iIN: break;
-                    default: ref = true;
-                }
-                
-                if(ref) {
-                    if(isSgPointerDerefExp(ex)) {}
-                    else {
-                        if(isSgVarRefExp(ex)) {}
+                bool parg = false;
+                if(intents!=NULL) {
+                    auto intent = (*intents)[ind++];
+                    bool ref = false;
+                    
+                    switch(intent) {
+                        case iIN: break;
+                        default: ref = true;
+                    }
+                    
+                    if(ref) {
+                        if(isSgPointerDerefExp(ex)) {}
                         else {
-                            any = true;
-                            parg = true;
+                            if(isSgVarRefExp(ex)) {}
+                            else {
+                                any = true;
+                                parg = true;
+                            }
                         }
                     }
                 }
+                
+                pointer_arg.push_back(parg);
             }
             
-            pointer_arg.push_back(parg);
-        }
-        
-        //compile function call.
-        ind = 0;
-        for(auto i = texprs.begin(); i!=texprs.end(); i++) {
-            auto* ex = *i;
-            
-            if(any) {
-                //need temporary variable
-                string name = genForVariableName("__arg");
-                SgType* type = ex->get_type();
-                auto* decl = buildVariableDeclaration(
-                    SgName(name), type,
-                    buildAssignInitializer(
-                        ex,
-                        type
-                    )
-                );
-                appendStatement(decl);
+            //compile function call.
+            ind = 0;
+            for(auto i = texprs.begin(); i!=texprs.end(); i++) {
+                auto* ex = *i;
                 
-                if(pointer_arg[ind]) {
-                    ret_exprs.push_back(
-                        buildAddressOfOp(
-                            buildVarRefExp(SgName(name))
+                if(any) {
+                    //need temporary variable
+                    string name = genForVariableName("__arg");
+                    SgType* type = ex->get_type()->stripType(SgType::STRIP_MODIFIER_TYPE);
+                    auto* decl = buildVariableDeclaration(
+                        SgName(name), type,
+                        buildAssignInitializer(
+                            ex,
+                            type
                         )
                     );
+                    appendStatement(decl);
+                    
+                    if(pointer_arg[ind]) {
+                        ret_exprs.push_back(
+                            buildAddressOfOp(
+                                buildVarRefExp(SgName(name))
+                            )
+                        );
+                    }else
+                        ret_exprs.push_back(buildVarRefExp(SgName(name)));
+                    
+                } else if(intents!=NULL) {
+                    auto intent = (*intents)[ind];
+                    bool ref = false;
+                    
+                    switch(intent) {
+                        case iIN: break;
+                        default: ref = true;
+                    }
+                    
+                    if(ref) {
+                        if(isSgPointerDerefExp(ex)) {
+                            auto* unop = isSgPointerDerefExp(ex);
+                            ret_exprs.push_back(unop->get_operand());
+                        }else
+                            ret_exprs.push_back(buildAddressOfOp(ex));   
+                    }else ret_exprs.push_back(ex);
                 }else
-                    ret_exprs.push_back(buildVarRefExp(SgName(name)));
-                
-            } else if(intents!=NULL) {
-                auto intent = (*intents)[ind];
-                bool ref = false;
-                
-                switch(intent) {
-                    case iIN: break;
-                    default: ref = true;
-                }
+                    ret_exprs.push_back(ex);
                 
-                if(ref) {
-                    if(isSgPointerDerefExp(ex)) {
-                        auto* unop = isSgPointerDerefExp(ex);
-                        ret_exprs.push_back(unop->get_operand());
-                    }else
-                        ret_exprs.push_back(buildAddressOfOp(ex));   
-                }else ret_exprs.push_back(ex);
-            }else
-                ret_exprs.push_back(ex);
-            
-            ind++;
+                ind++;
+            }
+       
+            return buildExprListExp(ret_exprs);
         }
-   
-        return buildExprListExp(ret_exprs);
+        
+        default: break;
     }
-
+    
+    //abstract node classes; no single variant to switch on.
+    if(isSgValueExp(expr)) {
+        auto* val = isSgValueExp(expr);
+        return xf_value_exp(val);
+    }
+    
+    if(isSgUnaryOp(expr)) {
+        auto* unop = isSgUnaryOp(expr);
+        return xf_unop_exp(unop);
+    }
+    
+    if(isSgBinaryOp(expr)) {
+        auto* binop = isSgBinaryOp(expr);
+        return xf_binop_exp(binop);
+    }
+    
     cout << expr->sage_class_name() << endl;
     throw (std::string)"Unhandled SgExpression in tcf::xf_expr :: SgExpression* -> SgExpression*";
     return NULL;
@@ -867,36 +1567,34 @@ SgExpression* ftc::xf_expr(SgExpression* expr, vector<Intent>* intents) {
 
 namespace ftc {
 
-    void GFinder::visit(SgNode* n) {
+    bool GFinder::preOrderVisit(SgNode* n) {
         if(isSgGlobal(n)) {
             ret = isSgGlobal(n);
-            throw 0;
+            stop();
         }
+        return true;
     }
     SgGlobal* GFinder::find(SgNode* root) {
+        //source files hold their global scope directly.
+        if(isSgSourceFile(root))
+            return isSgSourceFile(root)->get_globalScope();
+        
         ret = NULL;
-        try {
-            traverse(root,preorder);
-        }catch(...) {}
+        traverse(root);
         return ret;
     }
 
-    class XfVisitor : public AstPrePostProcessing {
-        //used when I want to skip the traversal of an entire sub-tree.
-        //keep ignoring nodes until postOrderVisit is called with the sync node.
-        SgNode* sync;
-        
+    //sub-trees of translated nodes are never descended into.
+    class XfVisitor : public PruningTraversal {
     public:
         //used to ignore parameter declarations in procedure bodies
         vector<SgInitializedName*>* arguments;
     
         XfVisitor() {
-            sync = NULL;
             arguments = NULL;
         }
 
-        void preOrderVisit(SgNode* n);
-        void postOrderVisit(SgNode* n);
+        bool preOrderVisit(SgNode* n);
     };
 }
 
@@ -939,6 +1637,33 @@ namespace ftc {
 
 namespace ftc {
 
+    //arguments of the procedure being translated that are used through a local copy, and so
+    //must be written back through their '__ref_' pointer before it returns.
+    vector<SgName> copy_out;
+    
+    void xf_copy_out() {
+        for(auto i = copy_out.begin(); i!=copy_out.end(); i++) {
+            xf_appendStatement(buildExprStatement(
+                buildAssignOp(
+                    buildPointerDerefExp(buildVarRefExp("__ref_" + (*i).getString())),
+                    buildVarRefExp(*i)
+                )
+            ));
+        }
+    }
+    
+    //allocatable arrays local to the procedure being translated, which fortran deallocates
+    //when it returns.
+    vector<SgName> local_allocatables;
+    
+    void xf_free_locals() {
+        for(auto i = local_allocatables.begin(); i!=local_allocatables.end(); i++) {
+            xf_appendStatement(buildExprStatement(
+                buildFunctionCallExp(buildFunctionRefExp(SgName("ftc__free")), buildExprListExp(buildVarRefExp(*i)))
+            ));
+        }
+    }
+    
     void xf_block(SgBasicBlock* fort_block, SgBasicBlock* c_block, vector<SgInitializedName*>* arguments=NULL, bool lazy=false) {
         assert(fort_block!=NULL);
         assert(c_block!=NULL);
@@ -975,19 +1700,28 @@ namespace ftc {
             cout << ".. " << fn_name.getString() << endl;
         #endif
         
-        auto intents = xf_fn_decl_intents(decl);
+        auto& fn_intents = xf_fn_decl_intents(decl);
+        auto& intents = fn_intents.intents;
         
         auto* fn_args = buildFunctionParameterList();
         auto args = decl->get_args();
-        for(auto i = args.begin(); i!=args.end(); i++) {
-            auto* init_name = *i;
+        
+        //scalar arguments passed by pointer but used through a local copy (--copy-scalars).
+        vector<pair<SgName,SgType*>> copies;
+        
+        for(unsigned int ind = 0; ind<args.size(); ind++) {
+            auto* init_name = args[ind];
             SgName arg_name = init_name->get_name();
             
             ArrDimAttribute* arr_attr = NULL;
             SgType* arg_type = ftc::xf_type(init_name->get_type(), true, &arr_attr);
             
-            assert(intents.find(arg_name.getString())!=intents.end());
-            auto intent = intents[arg_name.getString()];
+            auto intent = intents[ind];
+            
+            if(xf_options.copy_scalars && arr_attr==NULL && intent!=iIN) {
+                copies.push_back(pair<SgName,SgType*>(arg_name, arg_type));
+                arg_name = "__ref_" + arg_name.getString();
+            }
 
             switch(intent) {
                 case iIN: break;
@@ -995,6 +1729,17 @@ namespace ftc {
                     arg_type = buildPointerType(arg_type);
             }
             
+            //arrays the procedure may not modify point to const.
+            if(arr_attr!=NULL && fn_intents.declared[ind]==iIN) {
+                assert(isSgPointerType(arg_type));
+                arg_type = buildPointerType(buildConstType(isSgPointerType(arg_type)->get_base_type()));
+            }
+            
+            //fortran doesn't allow a dummy argument that is modified to alias any other, so every
+            //pointer argument can be restrict; allowing gcc to vectorise loops over them.
+            if(xf_options.restrict_args && isSgPointerType(arg_type))
+                arg_type = buildRestrictType(arg_type);
+            
             auto* iname = buildInitializedName(arg_name, arg_type);
             if(arr_attr!=NULL)
                 iname->addNewAttribute("dim", arr_attr);
@@ -1026,7 +1771,36 @@ namespace ftc {
             xf_appendStatement(ret_decl);
         }
         
-        xf_block(body, fn_body, &fn_decl->get_args(), true);
+        //copy in; the body only ever sees the local.
+        for(auto i = copies.begin(); i!=copies.end(); i++) {
+            auto* copy_decl = buildVariableDeclaration(
+                (*i).first, (*i).second,
+                buildAssignInitializer(
+                    buildPointerDerefExp(buildVarRefExp("__ref_" + (*i).first.getString()))
+                )
+            );
+            xf_appendStatement(copy_decl);
+        }
+        
+        //procedures may be nested in CONTAINS sections.
+        auto outer_copies = copy_out;
+        auto outer_allocatables = local_allocatables;
+        copy_out.clear();
+        local_allocatables.clear();
+        for(auto i = copies.begin(); i!=copies.end(); i++)
+            copy_out.push_back((*i).first);
+        
+        //compare against the fortran argument names, as some C ones were renamed.
+        xf_block(body, fn_body, &decl->get_args(), true);
+        
+        //copy out and deallocate when falling off the end.
+        if(!isSgReturnStmt(getLastStatement(fn_body))) {
+            xf_copy_out();
+            xf_free_locals();
+        }
+        
+        copy_out = outer_copies;
+        local_allocatables = outer_allocatables;
         
         xf_popScopeStack();
     }   
@@ -1034,6 +1808,48 @@ namespace ftc {
     //---------------------------------------------------------------------------------------------- 
     
     //arguments list so as to ignore declarations of those arguments in a procedure body.
+    //true for the deferred shape (:,...) of an allocatable array.
+    bool xf_deferred_shape(SgType* type) {
+        auto* arrtype = isSgArrayType(type);
+        if(arrtype==NULL) return false;
+        
+        auto dims = arrtype->get_dim_info()->get_expressions();
+        return !dims.empty() && isSgColonShapeExp(dims[0]);
+    }
+    
+    /*
+        an allocatable array is a null pointer and, for each dimension, a lower bound and extent
+        assigned by ALLOCATE:
+        
+            double* w = 0; int __w_lb0 = 1; int __w_n0 = 0; ...
+        
+        its ArrDimAttribute refers to those, so it's indexed like any other array.
+    */
+    void xf_alloc_decl(const SgName& name, SgArrayType* arrtype) {
+        SgType* base = ftc::xf_type(arrtype->get_base_type());
+        int rank = arrtype->get_dim_info()->get_expressions().size();
+        
+        auto* dimattr = new ArrDimAttribute;
+        SgExpression* size = NULL;
+        for(int d = 0; d<rank; d++) {
+            string lb = xf_alloc_bound(name.getString(), "lb", d);
+            string n  = xf_alloc_bound(name.getString(), "n", d);
+            xf_appendStatement(buildVariableDeclaration(SgName(lb), buildIntType(), buildAssignInitializer(buildIntVal(1))));
+            xf_appendStatement(buildVariableDeclaration(SgName(n),  buildIntType(), buildAssignInitializer(buildIntVal(0))));
+            
+            dimattr->lbounds.push_back(buildVarRefExp(SgName(lb)));
+            dimattr->extents.push_back(buildVarRefExp(SgName(n)));
+            if(d!=0)
+                dimattr->sizes.push_back(size);
+            if(d!=rank-1)
+                size = size==NULL ? (SgExpression*)buildVarRefExp(SgName(n)) : buildMultiplyOp(deepCopy(size), buildVarRefExp(SgName(n)));
+        }
+        
+        auto* var_decl = buildVariableDeclaration(name, buildPointerType(base), buildAssignInitializer(buildIntVal(0)));
+        var_decl->get_variables()[0]->addNewAttribute("dim", dimattr);
+        xf_appendStatement(var_decl);
+    }
+    
     void xf_var_decl(SgVariableDeclaration* decl, vector<SgInitializedName*>* arguments) {
         assert(decl!=NULL);
         
@@ -1075,6 +1891,15 @@ namespace ftc {
                 var_init = buildAssignInitializer(xf_expr(isSgAssignInitializer(init)->get_operand()));
             }
             
+            if(xf_deferred_shape(init_name->get_type())) {
+                xf_alloc_decl(var_name, isSgArrayType(init_name->get_type()));
+                if(getEnclosingFunctionDeclaration(decl)!=NULL)
+                    local_allocatables.push_back(var_name);
+                
+                includes.insert(pair<string,bool>("ftc_alloc.h",true));
+                continue;
+            }
+            
             //onwards!
             ArrDimAttribute* arr_attr = NULL;
             SgType* var_type = ftc::xf_type(init_name->get_type(), false, &arr_attr);
@@ -1085,115 +1910,1662 @@ namespace ftc {
         }
     }
     
-    //----------------------------------------------------------------------------------------------
+    //----------------------------------------------------------------------------------------------
+    
+    /*
+        openmp directives on DO loops.
+        
+        rose leaves '!$omp' lines as comments attached to the statement following them. a loop
+        directive (parallel do, do, simd, or a combination) is carried onto the C for statement
+        as the equivalent '#pragma omp'; other directives are dropped with the comments.
+        
+        C gives no variable the treatment fortran gives the counters of nested DO loops, which
+        are implicitly private, so they are made private explicitly. translator temporaries the
+        loop reads but which are declared before it (__fbound, __fstep, hoisted __fidx, ...) are
+        made firstprivate; those declared in the body (__arg, bounds of nested loops) are block
+        scoped and private already.
+    */
+    struct OmpDirective {
+        string construct;       //eg. "parallel for simd"; empty if the loop has no directive.
+        vector<string> clauses; //translated.
+        set<string> listed;     //variables named in a data-sharing clause.
+    };
+    
+    //the last '!$omp' directive before a statement, lowercased and continuation lines joined.
+    string xf_omp_text(SgStatement* stmt) {
+        auto* infos = stmt->getAttachedPreprocessingInfo();
+        if(infos==NULL) return "";
+        
+        string ret, directive;
+        for(auto i = infos->begin(); i!=infos->end(); i++) {
+            if((*i)->getRelativePosition()!=PreprocessingInfo::before) continue;
+            
+            stringstream lines((*i)->getString());
+            string line;
+            while(std::getline(lines, line)) {
+                std::transform(line.begin(), line.end(), line.begin(), ::tolower);
+                line.erase(0, line.find_first_not_of(" \t"));
+                if(line.compare(0, 5, "!$omp")!=0) continue;
+                
+                line.erase(0, line.find_first_not_of(" \t&", 5));
+                line.erase(line.find_last_not_of(" \t\r")+1);
+                
+                bool more = !line.empty() && line[line.size()-1]=='&';
+                if(more) line.erase(line.size()-1);
+                
+                directive += " " + line;
+                if(!more) {
+                    ret = directive;
+                    directive.clear();
+                }
+            }
+        }
+        return ret;
+    }
+    
+    //C name of a variable in an openmp clause. privatising or reducing a scalar argument
+    //passed by reference would privatise the pointer instead.
+    string xf_omp_var(string name, SgFortranDo* fdo, bool sharing) {
+        name.erase(0, name.find_first_not_of(" \t"));
+        name.erase(name.find_last_not_of(" \t")+1);
+        
+        auto* sym = lookupVariableSymbolInParentScopes(SgName(name));
+        if(sym==NULL)
+            throw (std::string)"Unknown variable '"+name+"' in OpenMP clause";
+        
+        if(sharing && isSgPointerType(sym->get_type()->stripType(SgType::STRIP_MODIFIER_TYPE))) {
+            auto* fsym = lookupVariableSymbolInParentScopes(SgName(name), fdo->get_scope());
+            if(fsym!=NULL && !isSgArrayType(fsym->get_type()))
+                throw (std::string)"OpenMP clause on '"+name+"', a scalar argument passed by reference; translate with --copy-scalars";
+        }
+        return name;
+    }
+    
+    //split a clause argument on top level commas.
+    vector<string> xf_omp_list(const string& text) {
+        vector<string> ret;
+        int depth = 0;
+        string item;
+        for(auto i = text.begin(); i!=text.end(); i++) {
+            if(*i=='(') depth++;
+            if(*i==')') depth--;
+            if(*i==',' && depth==0) {
+                ret.push_back(item);
+                item.clear();
+            }else
+                item += *i;
+        }
+        ret.push_back(item);
+        return ret;
+    }
+    
+    OmpDirective xf_omp_directive(SgFortranDo* fdo) {
+        OmpDirective ret;
+        string text = xf_omp_text(fdo);
+        
+        size_t pos = 0;
+        auto word = [&]() -> string {
+            pos = text.find_first_not_of(" \t,", pos);
+            if(pos==string::npos) { pos = text.size(); return ""; }
+            size_t end = text.find_first_of(" \t,(", pos);
+            if(end==string::npos) end = text.size();
+            string w = text.substr(pos, end-pos);
+            pos = end;
+            return w;
+        };
+        
+        //construct.
+        string construct;
+        size_t clauses_pos = pos;
+        for(string w = word(); w=="parallel" || w=="do" || w=="simd"; w = word()) {
+            construct += construct.empty() ? "" : " ";
+            construct += w=="do" ? "for" : w;
+            clauses_pos = pos;
+        }
+        pos = clauses_pos;
+        
+        //a parallel region of its own, or not a loop directive at all.
+        if(construct!="parallel for" && construct!="for" && construct!="simd"
+        && construct!="for simd" && construct!="parallel for simd") {
+            #if DEBUG
+                if(!text.empty()) cout << "dropped OpenMP directive:" << text << endl;
+            #endif
+            return ret;
+        }
+        ret.construct = construct;
+        
+        //clauses.
+        for(string name = word(); !name.empty(); name = word()) {
+            string args;
+            size_t open = text.find_first_not_of(" \t", pos);
+            if(open!=string::npos && text[open]=='(') {
+                int depth = 0;
+                size_t i = open;
+                for(; i<text.size(); i++) {
+                    if(text[i]=='(') depth++;
+                    if(text[i]==')' && --depth==0) break;
+                }
+                if(i==text.size())
+                    throw (std::string)"Unbalanced parentheses in OpenMP directive:"+text;
+                args = text.substr(open+1, i-open-1);
+                pos = i+1;
+            }
+            
+            if(name=="private" || name=="firstprivate" || name=="lastprivate" || name=="shared" || name=="copyin") {
+                auto vars = xf_omp_list(args);
+                string list;
+                for(auto i = vars.begin(); i!=vars.end(); i++) {
+                    string var = xf_omp_var(*i, fdo, name!="shared");
+                    ret.listed.insert(var);
+                    list += (list.empty() ? "" : ",") + var;
+                }
+                ret.clauses.push_back(name+"("+list+")");
+            }
+            else if(name=="reduction") {
+                size_t colon = args.find(':');
+                if(colon==string::npos)
+                    throw (std::string)"OpenMP reduction without an operator:"+text;
+                
+                string op = args.substr(0, colon);
+                op.erase(0, op.find_first_not_of(" \t"));
+                op.erase(op.find_last_not_of(" \t")+1);
+                
+                static map<string,string> ops = {
+                    {"+","+"}, {"-","-"}, {"*","*"}, {"max","max"}, {"min","min"},
+                    {".and.","&&"}, {".or.","||"}, {"iand","&"}, {"ior","|"}, {"ieor","^"}
+                };
+                auto found = ops.find(op);
+                if(found==ops.end())
+                    throw (std::string)"Unhandled OpenMP reduction operator '"+op+"'";
+                
+                auto vars = xf_omp_list(args.substr(colon+1));
+                string list;
+                for(auto i = vars.begin(); i!=vars.end(); i++) {
+                    string var = xf_omp_var(*i, fdo, true);
+                    ret.listed.insert(var);
+                    list += (list.empty() ? "" : ",") + var;
+                }
+                ret.clauses.push_back("reduction("+(*found).second+":"+list+")");
+            }
+            else if(name=="linear" || name=="aligned") {
+                size_t colon = args.find(':');
+                auto vars = xf_omp_list(args.substr(0, colon));
+                string list;
+                for(auto i = vars.begin(); i!=vars.end(); i++) {
+                    string var = xf_omp_var(*i, fdo, name=="linear");
+                    if(name=="linear") ret.listed.insert(var);
+                    list += (list.empty() ? "" : ",") + var;
+                }
+                ret.clauses.push_back(name+"("+list+(colon==string::npos ? "" : args.substr(colon))+")");
+            }
+            else if(name=="default") {
+                if(args.find("private")!=string::npos)
+                    throw (std::string)"Unhandled OpenMP clause default("+args+")";
+                ret.clauses.push_back(name+"("+args+")");
+            }
+            else if(name=="schedule" || name=="num_threads" || name=="if" || name=="safelen"
+                 || name=="simdlen" || name=="proc_bind" || name=="ordered" || name=="nowait") {
+                ret.clauses.push_back(args.empty() ? name : name+"("+args+")");
+            }
+            else if(name=="collapse") {
+                //the bounds of nested loops are computed between the loops.
+                throw (std::string)"OpenMP collapse is not supported";
+            }
+            else
+                throw (std::string)"Unhandled OpenMP clause '"+name+"'";
+        }
+        
+        return ret;
+    }
+    
+    //the pragma for a translated loop, given the variables to be made private/firstprivate.
+    string xf_omp_pragma(const OmpDirective& omp, SgFortranDo* fdo, const set<string>& counters,
+        const vector<string>& temps)
+    {
+        string ret = "#pragma omp " + omp.construct;
+        for(auto i = omp.clauses.begin(); i!=omp.clauses.end(); i++)
+            ret += " " + *i;
+        
+        string priv;
+        for(auto i = counters.begin(); i!=counters.end(); i++) {
+            if(omp.listed.find(*i)!=omp.listed.end()) continue;
+            priv += (priv.empty() ? "" : ",") + xf_omp_var(*i, fdo, true);
+        }
+        if(!priv.empty())
+            ret += " private(" + priv + ")";
+        
+        //simd has no firstprivate clause, and no threads to copy to.
+        string first;
+        for(auto i = temps.begin(); i!=temps.end(); i++)
+            first += (first.empty() ? "" : ",") + *i;
+        if(!first.empty() && omp.construct!="simd")
+            ret += " firstprivate(" + first + ")";
+        
+        return ret;
+    }
+    
+    //----------------------------------------------------------------------------------------------
+    
+    void xf_fortran_do(SgFortranDo* fdo) {
+        assert(fdo!=NULL);
+        
+        #if DEBUG
+            cout << "xf_fortran_do(.)" << endl;
+        #endif
+        
+        auto* do_init = fdo->get_initialization();
+        if(!isSgAssignOp(do_init)) {
+            throw (std::string)"Unhandled FortranDo Initialisation expression in ftc::xf_fortran_do";
+            return;
+        }
+        
+        auto* for_init_exp = isSgAssignOp(ftc::xf_expr(do_init));
+        auto* counter = for_init_exp->get_lhs_operand();
+        if(!isSgVarRefExp(counter)) {
+            throw (std::string)"Unhandled FortranDo Initialisation 2; assignOp LHS was not a variable";
+            return;
+        }
+        if(loop_stack.empty()) {
+            loop_writes.clear();
+            LoopWritesCollector collector;
+            collector.traverse(fdo);
+        }
+        
+        OmpDirective omp = xf_omp_directive(fdo);
+        bool omp_loop = !omp.construct.empty();
+        set<string> omp_private = loop_writes[fdo].counters;
+        vector<string> omp_temps;
+        
+        //
+        
+        //the bound is evaluated once, before the loop.
+        auto* do_bound = fdo->get_bound();
+        auto* bound_exp = ftc::xf_expr(do_bound);
+        SgExpression* bound = NULL;
+        if(isSgIntVal(bound_exp))
+            bound = bound_exp;
+        else {
+            string bound_name = genForVariableName("__fbound");
+            SgType* bound_type = ftc::xf_type(do_bound->get_type());
+            auto* bound_decl = buildVariableDeclaration(
+                SgName(bound_name), bound_type,
+                buildAssignInitializer(bound_exp)
+            );
+            xf_appendStatement(bound_decl);
+            bound = buildVarRefExp(SgName(bound_name));
+            omp_temps.push_back(bound_name);
+        }
+        
+        //
+        
+        //with a known step, a plain for loop gcc can compute the trip count of:
+        //    for(i = a; i <= b; i += s)       (>= for negative s)
+        auto* do_step = fdo->get_increment();
+        auto* step_exp = isSgNullExpression(do_step) ? NULL : ftc::xf_expr(do_step);
+        bool const_step = step_exp==NULL || isSgIntVal(step_exp);
+        int step = isSgIntVal(step_exp) ? isSgIntVal(step_exp)->get_value() : 1;
+        if(const_step && step==0)
+            throw (std::string)"Zero step in FortranDo in ftc::xf_fortran_do";
+        
+        SgStatement* for_init = NULL;
+        SgStatement* for_test = NULL;
+        SgExpression* for_step = NULL;
+        SgStatement* counter_init = NULL;
+        
+        if(const_step) {
+            for_init = buildExprStatement(for_init_exp);
+            
+            if(step>0)
+                 for_test = buildExprStatement(buildLessOrEqualOp   (deepCopy(counter), bound));
+            else for_test = buildExprStatement(buildGreaterOrEqualOp(deepCopy(counter), bound));
+            
+            if(step==1)
+                 for_step = buildPlusPlusOp(deepCopy(counter));
+            else for_step = buildPlusAssignOp(deepCopy(counter), buildIntVal(step));
+            
+            #if DEBUG
+                cout << ".. constant step " << step << endl;
+            #endif
+        }else {
+            //otherwise count down the trip count fortran defines, fixed before the loop:
+            //    i = a; __ftrip = (b - i + s)/s; for(; __ftrip > 0; __ftrip--, i += s)
+            //
+            //openmp needs the loop's direction known, so an omp loop counts up to it instead:
+            //    __ffirst = a; __ftrip = (b - __ffirst + s)/s;
+            //    for(__fk = 0; __fk < __ftrip; ++__fk) { i = __ffirst + __fk*s; ... }
+            string step_name = genForVariableName("__fstep");
+            SgType* step_type = ftc::xf_type(do_bound->get_type());
+            auto* step_decl = buildVariableDeclaration(
+                SgName(step_name), step_type,
+                buildAssignInitializer(step_exp)
+            );
+            xf_appendStatement(step_decl);
+            omp_temps.push_back(step_name);
+            
+            string first_name;
+            SgExpression* first = NULL;
+            if(!omp_loop) {
+                xf_appendStatement(buildExprStatement(for_init_exp));
+                first = deepCopy(counter);
+            }else {
+                first_name = genForVariableName("__ffirst");
+                auto* first_decl = buildVariableDeclaration(
+                    SgName(first_name), step_type,
+                    buildAssignInitializer(for_init_exp->get_rhs_operand())
+                );
+                xf_appendStatement(first_decl);
+                omp_temps.push_back(first_name);
+                first = buildVarRefExp(SgName(first_name));
+            }
+            
+            string trip_name = genForVariableName("__ftrip");
+            auto* trip_decl = buildVariableDeclaration(
+                SgName(trip_name), step_type,
+                buildAssignInitializer(
+                    buildDivideOp(
+                        buildAddOp(
+                            buildSubtractOp(bound, first),
+                            buildVarRefExp(SgName(step_name))
+                        ),
+                        buildVarRefExp(SgName(step_name))
+                    )
+                )
+            );
+            xf_appendStatement(trip_decl);
+            omp_temps.push_back(trip_name);
+            
+            if(!omp_loop) {
+                for_init = buildNullStatement();
+                for_test = buildExprStatement(buildGreaterThanOp(buildVarRefExp(SgName(trip_name)), buildIntVal(0)));
+                for_step = buildCommaOpExp(
+                    buildMinusMinusOp(buildVarRefExp(SgName(trip_name))),
+                    buildPlusAssignOp(deepCopy(counter), buildVarRefExp(SgName(step_name)))
+                );
+            }else {
+                string index_name = genForVariableName("__fk");
+                xf_appendStatement(buildVariableDeclaration(SgName(index_name), step_type));
+                
+                for_init = buildExprStatement(buildAssignOp(buildVarRefExp(SgName(index_name)), buildIntVal(0)));
+                for_test = buildExprStatement(buildLessThanOp(buildVarRefExp(SgName(index_name)), buildVarRefExp(SgName(trip_name))));
+                for_step = buildPlusPlusOp(buildVarRefExp(SgName(index_name)));
+                
+                counter_init = buildExprStatement(
+                    buildAssignOp(
+                        deepCopy(counter),
+                        buildAddOp(
+                            buildVarRefExp(SgName(first_name)),
+                            buildMultiplyOp(buildVarRefExp(SgName(index_name)), buildVarRefExp(SgName(step_name)))
+                        )
+                    )
+                );
+                omp_private.insert(isSgVarRefExp(counter)->get_symbol()->get_name().getString());
+            }
+        }
+        
+        auto* body = buildBasicBlock();
+        auto* forl = buildForStatement(for_init,for_test,for_step,body);
+        xf_appendStatement(forl);
+        if(counter_init!=NULL)
+            appendStatement(counter_init, body);
+        
+        LoopContext context;
+        context.loop = forl;
+        context.writes = &loop_writes[fdo];
+        loop_stack.push_back(context);
+                
+        xf_block(fdo->get_body(), body, NULL);
+        
+        //attached only now the body's invariant indices have been hoisted in front of the loop.
+        if(omp_loop) {
+            auto& hoisted = loop_stack.back().hoisted;
+            for(auto i = hoisted.begin(); i!=hoisted.end(); i++)
+                omp_temps.push_back((*i).second);
+            
+            attachArbitraryText(forl, xf_omp_pragma(omp, fdo, omp_private, omp_temps), PreprocessingInfo::before);
+        }
+        
+        loop_stack.pop_back();
+    }
+}
+
+///_________________________________________________________________________________________________
+///
+
+/**
+
+   Array expressions.
+
+   an assignment to a whole array or an array section, a = b + c*d or x(1:n) = y(2:n+1), is
+   translated as a single loop nest over the shape of its left hand side, each loop counting
+   from 0 so that gcc sees a canonical loop:
+
+       for(__fi1 = 0; __fi1 < n1; ++__fi1)
+           for(__fi0 = 0; __fi0 < n0; ++__fi0)
+               a[...] = b[...] + c[...]*d[...];
+
+   array operands are indexed by the counters of the dimensions they range over; scalar
+   operands are used as they are. the right hand side is evaluated into a temporary first
+   only if it reads the array being assigned other than element for element, or, with
+   --no-restrict, any other array argument when an argument is being assigned.
+
+**/
+
+namespace ftc {
+    //fortran intrinsics applied element by element to array arguments.
+    const set<string> elemental_intrinsics = {
+        "abs", "sqrt", "exp", "log", "log10", "sin", "cos", "tan", "asin", "acos", "atan",
+        "sinh", "cosh", "tanh", "int", "real"
+    };
+    
+    //number of dimensions a fortran expression ranges over; 0 for scalars.
+    int xf_rank(SgExpression* expr) {
+        switch(expr->variantT()) {
+            case V_SgVarRefExp: {
+                auto* type = isSgArrayType(isSgVarRefExp(expr)->get_symbol()->get_type());
+                return type==NULL ? 0 : type->get_dim_info()->get_expressions().size();
+            }
+            
+            case V_SgPntrArrRefExp: {
+                auto* subs = isSgExprListExp(isSgPntrArrRefExp(expr)->get_rhs_operand());
+                if(subs==NULL) return 0;
+                
+                int rank = 0;
+                auto exprs = subs->get_expressions();
+                for(auto i = exprs.begin(); i!=exprs.end(); i++)
+                    if(isSgSubscriptExpression(*i)) rank++;
+                return rank;
+            }
+            
+            case V_SgFunctionCallExp: {
+                auto* fcall = isSgFunctionCallExp(expr);
+                string fn = isSgFunctionRefExp(fcall->get_function())->get_symbol()->get_name().getString();
+                if(xf_get_fn_intents(fn)!=NULL || elemental_intrinsics.find(fn)==elemental_intrinsics.end())
+                    return 0;
+                
+                int rank = 0;
+                auto args = fcall->get_args()->get_expressions();
+                for(auto i = args.begin(); i!=args.end(); i++)
+                    rank = std::max(rank, xf_rank(*i));
+                return rank;
+            }
+            
+            default: break;
+        }
+        
+        if(isSgUnaryOp(expr))
+            return xf_rank(isSgUnaryOp(expr)->get_operand());
+        if(isSgBinaryOp(expr))
+            return std::max(xf_rank(isSgBinaryOp(expr)->get_lhs_operand()), xf_rank(isSgBinaryOp(expr)->get_rhs_operand()));
+        return 0;
+    }
+    
+    //an array operand: the C array, its fortran indices (NULL in the dimensions ranged over),
+    //and for each dimension ranged over, in order, its first index, stride (NULL for 1) and
+    //number of elements (NULL if unknown, for an assumed size array).
+    struct ArraySection {
+        SgVarRefExp* arr;
+        vector<SgExpression*> indices;
+        vector<int> dims;
+        vector<SgExpression*> lowers;
+        vector<SgExpression*> strides;
+        vector<SgExpression*> counts;
+    };
+    
+    ArraySection xf_array_section(SgExpression* expr, bool counts) {
+        ArraySection ret;
+        
+        auto* fvar = isSgVarRefExp(isSgPntrArrRefExp(expr) ? isSgPntrArrRefExp(expr)->get_lhs_operand() : expr);
+        ret.arr = fvar==NULL ? NULL : isSgVarRefExp(xf_expr(fvar));
+        if(ret.arr==NULL || !ret.arr->get_symbol()->get_declaration()->attributeExists("dim")) {
+            cout << expr->unparseToString() << endl;
+            throw (std::string)"Unhandled array operand in ftc::xf_array_section";
+        }
+        auto* dimattr = static_cast<ArrDimAttribute*>(ret.arr->get_symbol()->get_declaration()->getAttribute("dim"));
+        
+        //whole array.
+        if(isSgVarRefExp(expr)) {
+            for(int d = 0; d<dimattr->lbounds.size(); d++) {
+                ret.indices.push_back(NULL);
+                ret.dims.push_back(d);
+                ret.lowers.push_back(deepCopy(dimattr->lbounds[d]));
+                ret.strides.push_back(NULL);
+                if(counts)
+                    ret.counts.push_back(dimattr->extents[d]==NULL ? NULL : deepCopy(dimattr->extents[d]));
+            }
+            return ret;
+        }
+        
+        auto subs = isSgExprListExp(isSgPntrArrRefExp(expr)->get_rhs_operand())->get_expressions();
+        for(int d = 0; d<subs.size(); d++) {
+            auto* sub = isSgSubscriptExpression(subs[d]);
+            if(sub==NULL) {
+                ret.indices.push_back(xf_expr(subs[d]));
+                continue;
+            }
+            ret.indices.push_back(NULL);
+            ret.dims.push_back(d);
+            
+            bool whole_lower = isSgNullExpression(sub->get_lowerBound());
+            bool whole_upper = isSgNullExpression(sub->get_upperBound());
+            
+            auto* lower = whole_lower ? deepCopy(dimattr->lbounds[d]) : xf_expr(sub->get_lowerBound());
+            ret.lowers.push_back(lower);
+            
+            SgExpression* stride = NULL;
+            auto* fstride = sub->get_stride();
+            if(fstride!=NULL && !isSgNullExpression(fstride) && !(isSgIntVal(fstride) && isSgIntVal(fstride)->get_value()==1))
+                stride = xf_expr(fstride);
+            ret.strides.push_back(stride);
+            
+            if(!counts) continue;
+            
+            auto* extent = dimattr->extents[d];
+            SgExpression* count = NULL;
+            if(whole_lower && whole_upper && stride==NULL)
+                count = extent==NULL ? NULL : deepCopy(extent);
+            else {
+                SgExpression* upper = NULL;
+                if(!whole_upper)
+                    upper = xf_expr(sub->get_upperBound());
+                else if(extent!=NULL)
+                    upper = xf_index_sub(xf_index_add(deepCopy(dimattr->lbounds[d]), deepCopy(extent)), buildIntVal(1));
+                
+                //(upper - lower + stride)/stride
+                if(upper!=NULL) {
+                    count = xf_index_sub(upper, deepCopy(lower));
+                    if(stride==NULL)
+                        count = xf_index_add(count, buildIntVal(1));
+                    else if(isSgIntVal(count) && isSgIntVal(stride))
+                        count = buildIntVal((isSgIntVal(count)->get_value() + isSgIntVal(stride)->get_value())/isSgIntVal(stride)->get_value());
+                    else
+                        count = buildDivideOp(xf_index_add(count, deepCopy(stride)), deepCopy(stride));
+                }
+            }
+            ret.counts.push_back(count);
+        }
+        return ret;
+    }
+    
+    //element of an array section at the loop counters.
+    SgExpression* xf_section_element(ArraySection& section, const vector<string>& counters) {
+        if(section.dims.size()!=counters.size())
+            throw (std::string)"Array operands of different rank in ftc::xf_section_element";
+        
+        vector<SgExpression*> indices = section.indices;
+        for(int k = 0; k<section.dims.size(); k++)
+            indices[section.dims[k]] = xf_index_add(
+                xf_index_mul(buildVarRefExp(SgName(counters[k])), section.strides[k]),
+                section.lowers[k]
+            );
+        return xf_arr_ref(section.arr, indices);
+    }
+    
+    //C expression for one element of a fortran array expression.
+    SgExpression* xf_element(SgExpression* expr, const vector<string>& counters) {
+        if(xf_rank(expr)==0) return ftc::xf_expr(expr);
+        
+        switch(expr->variantT()) {
+            case V_SgVarRefExp:
+            case V_SgPntrArrRefExp: {
+                auto section = xf_array_section(expr, false);
+                return xf_section_element(section, counters);
+            }
+            
+            case V_SgFunctionCallExp: {
+                auto* fcall = isSgFunctionCallExp(expr);
+                string fn = isSgFunctionRefExp(fcall->get_function())->get_symbol()->get_name().getString();
+                
+                vector<SgExpression*> args;
+                auto fargs = fcall->get_args()->get_expressions();
+                for(auto i = fargs.begin(); i!=fargs.end(); i++)
+                    args.push_back(xf_element(*i, counters));
+                
+                if(fn.compare("int")==0)  return buildCastExp(args[0], buildIntType());
+                if(fn.compare("real")==0) return buildCastExp(args[0], buildDoubleType());
+                if(fn.compare("abs")==0 && !isSgTypeInt(args[0]->get_type())) fn = "fabs";
+                
+                return buildFunctionCallExp(buildFunctionRefExp(SgName(fn)), buildExprListExp(args));
+            }
+            
+            default: break;
+        }
+        
+        if(isSgUnaryOp(expr))
+            return xf_unop_exp(isSgUnaryOp(expr), xf_element(isSgUnaryOp(expr)->get_operand(), counters));
+        if(isSgBinaryOp(expr)) {
+            auto* binop = isSgBinaryOp(expr);
+            return xf_binop_exp(binop, xf_element(binop->get_lhs_operand(), counters), xf_element(binop->get_rhs_operand(), counters));
+        }
+        
+        cout << expr->sage_class_name() << endl;
+        throw (std::string)"Unhandled array expression in ftc::xf_element";
+    }
+    
+    //names of the arrays a fortran expression reads. an elementwise operand with text 'lhs' only
+    //reads the element being assigned, so is skipped; any other reference counts, including one
+    //under a scalar (a(1), sum(a)), a procedure call or a subscript.
+    void xf_arrays_read(SgExpression* expr, const string& lhs, set<string>& names, bool elementwise = true) {
+        if(elementwise && (isSgVarRefExp(expr) || isSgPntrArrRefExp(expr)) && xf_rank(expr)>0 && expr->unparseToString()==lhs)
+            return;
+        
+        if(isSgVarRefExp(expr)) {
+            auto* sym = isSgVarRefExp(expr)->get_symbol();
+            if(isSgArrayType(sym->get_type()))
+                names.insert(sym->get_name().getString());
+            return;
+        }
+        
+        //operands of elemental operations and calls are elementwise in turn.
+        elementwise = elementwise && xf_rank(expr)>0 && !isSgPntrArrRefExp(expr)
+                   && (isSgUnaryOp(expr) || isSgBinaryOp(expr) || isSgFunctionCallExp(expr));
+        
+        if(isSgFunctionCallExp(expr)) {
+            auto args = isSgFunctionCallExp(expr)->get_args()->get_expressions();
+            for(auto i = args.begin(); i!=args.end(); i++)
+                xf_arrays_read(*i, lhs, names, elementwise);
+            return;
+        }
+        
+        auto children = expr->get_traversalSuccessorContainer();
+        for(auto i = children.begin(); i!=children.end(); i++)
+            if(isSgExpression(*i)) xf_arrays_read(isSgExpression(*i), lhs, names, elementwise);
+    }
+    
+    //evaluates the scalar operands of an array expression (sum(b), f(x), a(1), section bounds)
+    //into temporaries ahead of its loop nest, for xf_expr to use inside it. literals and scalar
+    //variables are left in place. 'hoisted' gets the operands, to be dropped again with
+    //xf_drop_scalars once the nest is done.
+    void xf_hoist_scalars(SgExpression* expr, vector<SgExpression*>& hoisted) {
+        if(isSgValueExp(expr) || isSgNullExpression(expr) || isSgAsteriskShapeExp(expr)
+        || (isSgVarRefExp(expr) && xf_rank(expr)==0))
+            return;
+        
+        if(!isSgSubscriptExpression(expr) && !isSgExprListExp(expr) && xf_rank(expr)==0) {
+            auto* value = xf_expr(expr);
+            if(!isSgValueExp(value)) {
+                string name = genForVariableName("__fscl");
+                SgType* type = value->get_type()->stripType(SgType::STRIP_MODIFIER_TYPE);
+                xf_appendStatement(buildVariableDeclaration(SgName(name), type, buildAssignInitializer(value, type)));
+                value = buildVarRefExp(SgName(name));
+            }
+            hoisted_scalars[expr] = value;
+            hoisted.push_back(expr);
+            return;
+        }
+        
+        if(isSgFunctionCallExp(expr)) {
+            xf_hoist_scalars(isSgFunctionCallExp(expr)->get_args(), hoisted);
+            return;
+        }
+        
+        //whole arrays; the operands of elemental operations, and the subscripts of sections.
+        if(isSgVarRefExp(expr)) return;
+        auto children = expr->get_traversalSuccessorContainer();
+        for(auto i = children.begin(); i!=children.end(); i++)
+            if(isSgExpression(*i) && !(isSgPntrArrRefExp(expr) && i==children.begin()))
+                xf_hoist_scalars(isSgExpression(*i), hoisted);
+    }
+    
+    void xf_drop_scalars(const vector<SgExpression*>& hoisted) {
+        for(auto i = hoisted.begin(); i!=hoisted.end(); i++)
+            hoisted_scalars.erase(*i);
+    }
+    
+    class CallFinder : public PruningTraversal {
+    public:
+        bool found;
+        CallFinder() : found(false) {}
+    protected:
+        bool preOrderVisit(SgNode* n) {
+            if(isSgFunctionCallExp(n)) {
+                found = true;
+                stop();
+            }
+            return true;
+        }
+    };
+    
+    //opens a loop nest counting 0 <= counters[k] < counts[k], counters[0] innermost, and makes
+    //its body the current scope. closed by xf_array_nest_end.
+    void xf_array_nest(const vector<string>& counters, const vector<SgExpression*>& counts, const LoopWrites* writes) {
+        for(int k = counters.size()-1; k>=0; k--) {
+            auto* body = buildBasicBlock();
+            auto* forl = buildForStatement(
+                buildExprStatement(buildAssignOp(buildVarRefExp(SgName(counters[k])), buildIntVal(0))),
+                buildExprStatement(buildLessThanOp(buildVarRefExp(SgName(counters[k])), deepCopy(counts[k]))),
+                buildPlusPlusOp(buildVarRefExp(SgName(counters[k]))),
+                body
+            );
+            xf_appendStatement(forl);
+            xf_pushScopeStack(body);
+            
+            LoopContext context;
+            context.loop = forl;
+            context.writes = writes;
+            loop_stack.push_back(context);
+        }
+    }
+    void xf_array_nest_end(int depth) {
+        for(int k = 0; k<depth; k++) {
+            loop_stack.pop_back();
+            xf_popScopeStack();
+        }
+    }
+    
+    //declares the counters of a loop nest over an array section's shape, and its counts, each
+    //evaluated once.
+    void xf_array_counters(ArraySection& shape, vector<string>& counters, vector<SgExpression*>& counts) {
+        for(int k = 0; k<shape.counts.size(); k++) {
+            auto* count = shape.counts[k];
+            if(count==NULL)
+                throw (std::string)"Array operation on an assumed size array without an upper bound in ftc::xf_array_counters";
+            
+            if(!isSgIntVal(count)) {
+                string bound_name = genForVariableName("__fbound");
+                xf_appendStatement(buildVariableDeclaration(SgName(bound_name), buildIntType(), buildAssignInitializer(count)));
+                count = buildVarRefExp(SgName(bound_name));
+            }
+            counts.push_back(count);
+            
+            string counter = genForVariableName("__fi");
+            xf_appendStatement(buildVariableDeclaration(SgName(counter), buildIntType()));
+            counters.push_back(counter);
+        }
+    }
+    
+    void xf_matmul_assign(SgExpression* lhs, SgFunctionCallExp* fcall);
+    
+    void xf_array_assign(SgAssignOp* assign) {
+        assert(assign!=NULL);
+        
+        #if DEBUG
+            cout << "xf_array_assign(.)" << endl;
+        #endif
+        
+        auto* lhs = assign->get_lhs_operand();
+        auto* rhs = assign->get_rhs_operand();
+        
+        int rank = xf_rank(lhs);
+        int rhs_rank = xf_rank(rhs);
+        if(rhs_rank!=0 && rhs_rank!=rank)
+            throw (std::string)"Array assignment of different ranks in ftc::xf_array_assign";
+        
+        if(isSgFunctionCallExp(rhs) && xf_intrinsic_name(isSgFunctionCallExp(rhs))=="matmul") {
+            xf_matmul_assign(lhs, isSgFunctionCallExp(rhs));
+            return;
+        }
+        
+        //the shape is that of the left hand side.
+        auto shape = xf_array_section(lhs, true);
+        
+        vector<string> counters;
+        vector<SgExpression*> counts;
+        xf_array_counters(shape, counters, counts);
+        
+        LoopWrites writes;
+        writes.written.insert(counters.begin(), counters.end());
+        CallFinder calls;
+        calls.traverse(rhs);
+        writes.calls = calls.found;
+        
+        //does the right hand side read what's being assigned?
+        string lhs_name = shape.arr->get_symbol()->get_name().getString();
+        auto* lhs_type = shape.arr->get_symbol()->get_type()->stripType(SgType::STRIP_MODIFIER_TYPE);
+        
+        set<string> read;
+        xf_arrays_read(rhs, lhs->unparseToString(), read);
+        bool alias = read.find(lhs_name)!=read.end();
+        
+        vector<SgExpression*> hoisted;
+        xf_hoist_scalars(rhs, hoisted);
+        if(!alias && !xf_options.restrict_args && isSgPointerType(lhs_type)) {
+            for(auto i = read.begin(); i!=read.end() && !alias; i++) {
+                auto* sym = lookupVariableSymbolInParentScopes(SgName(*i));
+                alias = sym!=NULL && isSgPointerType(sym->get_type()->stripType(SgType::STRIP_MODIFIER_TYPE));
+            }
+        }
+        
+        if(!alias) {
+            xf_array_nest(counters, counts, &writes);
+            auto* value = xf_element(rhs, counters);
+            xf_appendStatement(buildExprStatement(buildAssignOp(xf_section_element(shape, counters), value)));
+            xf_array_nest_end(rank);
+            xf_drop_scalars(hoisted);
+            return;
+        }
+        
+        #if DEBUG
+            cout << ".. through a temporary" << endl;
+        #endif
+        
+        //T* __ftmp = (T*)malloc(sizeof(T)*total); ... free(__ftmp);
+        SgType* elem_type = isSgArrayType(lhs_type) ? isSgArrayType(lhs_type)->get_base_type()
+                                                    : isSgPointerType(lhs_type)->get_base_type();
+        SgExpression* total = NULL;
+        SgExpression* linear = NULL;
+        for(int k = rank-1; k>=0; k--) {
+            total = total==NULL ? deepCopy(counts[k]) : xf_index_mul(total, deepCopy(counts[k]));
+            linear = linear==NULL ? buildVarRefExp(SgName(counters[k]))
+                                  : xf_index_add(buildVarRefExp(SgName(counters[k])), xf_index_mul(linear, deepCopy(counts[k])));
+        }
+        
+        includes.insert(pair<string,bool>("stdlib.h",true));
+        string tmp_name = genForVariableName("__ftmp");
+        xf_appendStatement(buildVariableDeclaration(
+            SgName(tmp_name), buildPointerType(elem_type),
+            buildAssignInitializer(
+                buildCastExp(
+                    buildFunctionCallExp(
+                        buildFunctionRefExp(SgName("malloc")),
+                        buildExprListExp(buildMultiplyOp(buildSizeOfOp(elem_type), total))
+                    ),
+                    buildPointerType(elem_type)
+                )
+            )
+        ));
+        
+        xf_array_nest(counters, counts, &writes);
+        auto* value = xf_element(rhs, counters);
+        xf_appendStatement(buildExprStatement(buildAssignOp(buildPntrArrRefExp(buildVarRefExp(SgName(tmp_name)), linear), value)));
+        xf_array_nest_end(rank);
+        xf_drop_scalars(hoisted);
+        
+        xf_array_nest(counters, counts, &writes);
+        xf_appendStatement(buildExprStatement(buildAssignOp(xf_section_element(shape, counters),
+            buildPntrArrRefExp(buildVarRefExp(SgName(tmp_name)), deepCopy(linear)))));
+        xf_array_nest_end(rank);
+        
+        xf_appendStatement(buildExprStatement(
+            buildFunctionCallExp(buildFunctionRefExp(SgName("free")), buildExprListExp(buildVarRefExp(SgName(tmp_name))))
+        ));
+    }
+}
+
+///_________________________________________________________________________________________________
+///
+
+/**
+
+   Array intrinsics.
+
+   sum, product, maxval, minval and dot_product of contiguous arrays (whole arrays, and
+   sections a(l:u,j,...) ranging over the first dimension only) call the kind specific
+   entry points of ftc_intrinsics.h. of any other array expression they are computed in
+   place by a loop nest like that of an array assignment.
+
+   c = matmul(a,b) calls ftc__matmul for whole arrays a, b and c.
+
+**/
+
+namespace ftc {
+    const set<string> array_intrinsics = { "sum", "product", "maxval", "minval", "dot_product", "matmul" };
+    
+    //name of the array intrinsic called, or "" if it isn't one (or has been redefined).
+    string xf_intrinsic_name(SgFunctionCallExp* fcall) {
+        auto* fref = isSgFunctionRefExp(fcall->get_function());
+        if(fref==NULL) return "";
+        
+        string fn = fref->get_symbol()->get_name().getString();
+        if(array_intrinsics.find(fn)==array_intrinsics.end() || xf_get_fn_intents(fn)!=NULL)
+            return "";
+        return fn;
+    }
+    
+    //C element type of an array.
+    SgType* xf_elem_type(SgVarRefExp* arr) {
+        auto* type = arr->get_symbol()->get_type()->stripType(SgType::STRIP_MODIFIER_TYPE);
+        if(isSgArrayType(type))   type = isSgArrayType(type)->get_base_type();
+        if(isSgPointerType(type)) type = isSgPointerType(type)->get_base_type();
+        return type->stripType(SgType::STRIP_MODIFIER_TYPE);
+    }
+    
+    //suffix of the ftc_intrinsics.h entry points for a C element type; "" if there are none.
+    string xf_kind_suffix(SgType* type) {
+        if(isSgTypeDouble(type)) return "_r8";
+        if(isSgTypeFloat(type))  return "_r4";
+        if(isSgTypeInt(type))    return "_i4";
+        if(isSgTypeLong(type))   return "_i8";
+        return "";
+    }
+    
+    //number of elements of a whole array; NULL if not known.
+    SgExpression* xf_array_size(SgVarRefExp* arr) {
+        auto* dimattr = static_cast<ArrDimAttribute*>(arr->get_symbol()->get_declaration()->getAttribute("dim"));
+        SgExpression* ret = NULL;
+        for(auto i = dimattr->extents.begin(); i!=dimattr->extents.end(); i++) {
+            if(*i==NULL) return NULL;
+            ret = ret==NULL ? deepCopy(*i) : xf_index_mul(ret, deepCopy(*i));
+        }
+        return ret;
+    }
+    
+    //pointer to the first element of a contiguous array operand, its element type and number
+    //of elements. false if the operand isn't contiguous or its size isn't known.
+    bool xf_contiguous(SgExpression* expr, SgExpression*& first, SgType*& type, SgExpression*& count) {
+        if(!(isSgVarRefExp(expr) || isSgPntrArrRefExp(expr)) || xf_rank(expr)==0)
+            return false;
+        
+        auto section = xf_array_section(expr, true);
+        type = xf_elem_type(section.arr);
+        
+        if(isSgVarRefExp(expr)) {
+            first = section.arr;
+            count = xf_array_size(section.arr);
+            return count!=NULL;
+        }
+        
+        if(section.dims.size()!=1 || section.dims[0]!=0 || section.strides[0]!=NULL || section.counts[0]==NULL)
+            return false;
+        
+        auto indices = section.indices;
+        indices[0] = section.lowers[0];
+        first = buildAddressOfOp(xf_arr_ref(section.arr, indices));
+        count = section.counts[0];
+        return true;
+    }
+    
+    //whether xf_contiguous takes 'expr', and its element type. decided on the fortran operand,
+    //translating only the array's name, so an operand that ends up in a loop instead isn't
+    //translated (with its temporaries and hoisted indices) twice.
+    bool xf_contiguous_operand(SgExpression* expr, SgType*& type) {
+        if(!(isSgVarRefExp(expr) || isSgPntrArrRefExp(expr)) || xf_rank(expr)==0)
+            return false;
+        
+        auto* fvar = isSgVarRefExp(isSgPntrArrRefExp(expr) ? isSgPntrArrRefExp(expr)->get_lhs_operand() : expr);
+        auto* arr = fvar==NULL ? NULL : isSgVarRefExp(xf_expr(fvar));
+        if(arr==NULL || !arr->get_symbol()->get_declaration()->attributeExists("dim"))
+            return false;
+        auto* dimattr = static_cast<ArrDimAttribute*>(arr->get_symbol()->get_declaration()->getAttribute("dim"));
+        type = xf_elem_type(arr);
+        
+        if(isSgVarRefExp(expr)) {
+            for(auto i = dimattr->extents.begin(); i!=dimattr->extents.end(); i++)
+                if(*i==NULL) return false;
+            return true;
+        }
+        
+        //a(l:u, j, k, ...)
+        auto subs = isSgExprListExp(isSgPntrArrRefExp(expr)->get_rhs_operand())->get_expressions();
+        for(int d = 1; d<subs.size(); d++)
+            if(isSgSubscriptExpression(subs[d])) return false;
+        
+        auto* sub = isSgSubscriptExpression(subs[0]);
+        if(sub==NULL) return false;
+        auto* fstride = sub->get_stride();
+        if(fstride!=NULL && !isSgNullExpression(fstride) && !(isSgIntVal(fstride) && isSgIntVal(fstride)->get_value()==1))
+            return false;
+        return !isSgNullExpression(sub->get_upperBound()) || dimattr->extents[0]!=NULL;
+    }
+    
+    //first whole array or section in an array expression.
+    SgExpression* xf_array_operand(SgExpression* expr) {
+        if((isSgVarRefExp(expr) || isSgPntrArrRefExp(expr)) && xf_rank(expr)>0)
+            return expr;
+        
+        auto children = expr->get_traversalSuccessorContainer();
+        for(auto i = children.begin(); i!=children.end(); i++) {
+            auto* child = isSgExpression(*i);
+            if(child==NULL || xf_rank(child)==0) continue;
+            
+            auto* ret = xf_array_operand(child);
+            if(ret!=NULL) return ret;
+        }
+        return NULL;
+    }
+    
+    //reduction of an array expression (the product of two for dot_product) by a loop nest:
+    //
+    //    T __facc = init; for(...) __facc += elem;
+    SgExpression* xf_reduction_loop(const string& fn, SgExpression* fexpr, SgExpression* fexpr2) {
+        auto* operand = xf_array_operand(fexpr);
+        if(operand==NULL)
+            throw (std::string)"Array intrinsic "+fn+" of a scalar in ftc::xf_reduction_loop";
+        
+        auto shape = xf_array_section(operand, true);
+        SgType* type = xf_elem_type(shape.arr);
+        
+        vector<string> counters;
+        vector<SgExpression*> counts;
+        xf_array_counters(shape, counters, counts);
+        
+        //start from the identity, or from -huge/huge as fortran has it for no elements.
+        SgExpression* init = NULL;
+        bool integer = type->isIntegerType();
+        if(fn=="sum" || fn=="dot_product") init = buildIntVal(0);
+        else if(fn=="product") init = buildIntVal(1);
+        else {
+            string limit = isSgTypeLong(type) ? "LONG" : integer ? "INT" : isSgTypeFloat(type) ? "FLT" : "DBL";
+            includes.insert(pair<string,bool>(integer ? "limits.h" : "float.h", true));
+            
+            if(fn=="maxval")
+                 init = integer ? (SgExpression*)buildVarRefExp(SgName(limit+"_MIN")) : buildMinusOp(buildVarRefExp(SgName(limit+"_MAX")));
+            else init = buildVarRefExp(SgName(limit+"_MAX"));
+        }
+        
+        string acc = genForVariableName("__facc");
+        xf_appendStatement(buildVariableDeclaration(SgName(acc), type, buildAssignInitializer(init)));
+        
+        LoopWrites writes;
+        writes.written.insert(counters.begin(), counters.end());
+        CallFinder calls;
+        calls.traverse(fexpr);
+        if(fexpr2!=NULL) calls.traverse(fexpr2);
+        writes.calls = calls.found;
+        
+        vector<SgExpression*> hoisted;
+        xf_hoist_scalars(fexpr, hoisted);
+        if(fexpr2!=NULL) xf_hoist_scalars(fexpr2, hoisted);
+        
+        xf_array_nest(counters, counts, &writes);
+        
+        auto* elem = xf_element(fexpr, counters);
+        if(fexpr2!=NULL)
+            elem = buildMultiplyOp(elem, xf_element(fexpr2, counters));
+        
+        if(fn=="sum" || fn=="dot_product")
+            xf_appendStatement(buildExprStatement(buildPlusAssignOp(buildVarRefExp(SgName(acc)), elem)));
+        else if(fn=="product")
+            xf_appendStatement(buildExprStatement(buildMultAssignOp(buildVarRefExp(SgName(acc)), elem)));
+        else {
+            //T __fv = elem; __facc = __fv > __facc ? __fv : __facc;
+            string value = genForVariableName("__fv");
+            xf_appendStatement(buildVariableDeclaration(SgName(value), type, buildAssignInitializer(elem)));
+            
+            SgExpression* cmp = NULL;
+            if(fn=="maxval")
+                 cmp = buildGreaterThanOp(buildVarRefExp(SgName(value)), buildVarRefExp(SgName(acc)));
+            else cmp = buildLessThanOp   (buildVarRefExp(SgName(value)), buildVarRefExp(SgName(acc)));
+            
+            xf_appendStatement(buildExprStatement(buildAssignOp(
+                buildVarRefExp(SgName(acc)),
+                buildConditionalExp(cmp, buildVarRefExp(SgName(value)), buildVarRefExp(SgName(acc)))
+            )));
+        }
+        
+        xf_array_nest_end(counters.size());
+        xf_drop_scalars(hoisted);
+        return buildVarRefExp(SgName(acc));
+    }
+    
+    SgExpression* xf_intrinsic_call(SgFunctionCallExp* fcall) {
+        string fn = xf_intrinsic_name(fcall);
+        auto args = fcall->get_args()->get_expressions();
+        
+        #if DEBUG
+            cout << "xf_intrinsic_call(" << fn << ")" << endl;
+        #endif
+        
+        if(fn=="matmul")
+            throw (std::string)"MATMUL is only handled as the whole right hand side of an array assignment";
+        
+        bool dot = fn=="dot_product";
+        if(args.size()!=(dot ? 2 : 1))
+            throw (std::string)"Unhandled arguments to "+fn+" (dim and mask aren't supported) in ftc::xf_intrinsic_call";
+        
+        SgExpression* first = NULL;
+        SgExpression* count = NULL;
+        SgType* type = NULL;
+        
+        //operands are only translated once it is known which way they go.
+        if(!dot && xf_contiguous_operand(args[0], type) && !xf_kind_suffix(type).empty()) {
+            xf_contiguous(args[0], first, type, count);
+            includes.insert(pair<string,bool>("ftc_intrinsics.h",true));
+            return buildFunctionCallExp(SgName("ftc__"+fn+xf_kind_suffix(type)), type, buildExprListExp(first, count));
+        }
+        
+        SgExpression* first2 = NULL;
+        SgExpression* count2 = NULL;
+        SgType* type2 = NULL;
+        
+        if(dot && xf_contiguous_operand(args[0], type) && xf_contiguous_operand(args[1], type2)
+        && !xf_kind_suffix(type).empty() && xf_kind_suffix(type)==xf_kind_suffix(type2)) {
+            xf_contiguous(args[0], first, type, count);
+            xf_contiguous(args[1], first2, type2, count2);
+            includes.insert(pair<string,bool>("ftc_intrinsics.h",true));
+            return buildFunctionCallExp(SgName("ftc__"+fn+xf_kind_suffix(type)), type, buildExprListExp(first, first2, count));
+        }
+        
+        return xf_reduction_loop(fn, args[0], dot ? args[1] : NULL);
+    }
+    
+    //c = matmul(a,b) for whole arrays; a or b may be vectors.
+    void xf_matmul_assign(SgExpression* lhs, SgFunctionCallExp* fcall) {
+        auto args = fcall->get_args()->get_expressions();
+        if(args.size()!=2 || !isSgVarRefExp(lhs) || !isSgVarRefExp(args[0]) || !isSgVarRefExp(args[1]))
+            throw (std::string)"MATMUL is only handled for whole arrays in ftc::xf_matmul_assign";
+        
+        auto c = xf_array_section(lhs, true);
+        auto a = xf_array_section(args[0], true);
+        auto b = xf_array_section(args[1], true);
+        
+        string suffix = xf_kind_suffix(xf_elem_type(c.arr));
+        if(suffix.empty() || suffix!=xf_kind_suffix(xf_elem_type(a.arr)) || suffix!=xf_kind_suffix(xf_elem_type(b.arr)))
+            throw (std::string)"MATMUL of mixed or unhandled kinds in ftc::xf_matmul_assign";
+        
+        for(auto i = a.counts.begin(); i!=a.counts.end(); i++)
+            if(*i==NULL) throw (std::string)"MATMUL of an assumed size array in ftc::xf_matmul_assign";
+        for(auto i = b.counts.begin(); i!=b.counts.end(); i++)
+            if(*i==NULL) throw (std::string)"MATMUL of an assumed size array in ftc::xf_matmul_assign";
+        
+        //a is m x k (1 x k for a vector), b is k x n (k x 1).
+        SgExpression* m = a.counts.size()==2 ? a.counts[0] : buildIntVal(1);
+        SgExpression* k = a.counts.back();
+        SgExpression* n = b.counts.size()==2 ? b.counts[1] : buildIntVal(1);
+        
+        includes.insert(pair<string,bool>("ftc_intrinsics.h",true));
+        string fn = "ftc__matmul"+suffix;
+        
+        //the result can't be written over an operand while it's still being read.
+        string lhs_name = c.arr->get_symbol()->get_name().getString();
+        if(lhs_name!=a.arr->get_symbol()->get_name().getString() && lhs_name!=b.arr->get_symbol()->get_name().getString()) {
+            vector<SgExpression*> call_args = { c.arr, a.arr, b.arr, m, k, n };
+            xf_appendStatement(buildExprStatement(buildFunctionCallExp(SgName(fn), buildVoidType(), buildExprListExp(call_args))));
+            return;
+        }
+        
+        //T* __ftmp = (T*)malloc(sizeof(T)*m*n); ftc__matmul(__ftmp,...); memcpy(c,__ftmp,...); free(__ftmp);
+        SgType* elem_type = xf_elem_type(c.arr);
+        SgExpression* bytes = xf_index_mul(xf_index_mul(deepCopy(m), deepCopy(n)), buildSizeOfOp(elem_type));
+        
+        includes.insert(pair<string,bool>("stdlib.h",true));
+        includes.insert(pair<string,bool>("string.h",true));
+        string tmp_name = genForVariableName("__ftmp");
+        xf_appendStatement(buildVariableDeclaration(
+            SgName(tmp_name), buildPointerType(elem_type),
+            buildAssignInitializer(
+                buildCastExp(
+                    buildFunctionCallExp(buildFunctionRefExp(SgName("malloc")), buildExprListExp(bytes)),
+                    buildPointerType(elem_type)
+                )
+            )
+        ));
+        
+        vector<SgExpression*> call_args = { buildVarRefExp(SgName(tmp_name)), a.arr, b.arr, m, k, n };
+        xf_appendStatement(buildExprStatement(buildFunctionCallExp(SgName(fn), buildVoidType(), buildExprListExp(call_args))));
+        xf_appendStatement(buildExprStatement(buildFunctionCallExp(
+            buildFunctionRefExp(SgName("memcpy")),
+            buildExprListExp(c.arr, buildVarRefExp(SgName(tmp_name)), deepCopy(bytes))
+        )));
+        xf_appendStatement(buildExprStatement(
+            buildFunctionCallExp(buildFunctionRefExp(SgName("free")), buildExprListExp(buildVarRefExp(SgName(tmp_name))))
+        ));
+    }
+}
+
+///_________________________________________________________________________________________________
+///
+
+/**
+
+   ALLOCATE and DEALLOCATE.
+
+   allocate(w(n,0:m)) sets the bounds declared by xf_alloc_decl and allocates the array from
+   ftc_alloc.h; deallocate(w) frees it and leaves it unallocated:
+
+       __w_lb0 = 1; __w_n0 = n; __w_lb1 = 0; __w_n1 = m + 1;
+       w = (double*)ftc__alloc(sizeof(double)*__w_n0*__w_n1);
+       ...
+       ftc__free(w); w = 0; __w_n0 = 0; __w_n1 = 0;
+
+   ftc__alloc doesn't fail, so a stat= variable is always set to 0.
+
+**/
+
+namespace ftc {
+    void xf_allocate(SgAllocateStatement* alloc) {
+        assert(alloc!=NULL);
+        
+        #if DEBUG
+            cout << "xf_allocate(.)" << endl;
+        #endif
+        
+        includes.insert(pair<string,bool>("ftc_alloc.h",true));
+        
+        auto exprs = alloc->get_expr_list()->get_expressions();
+        for(auto i = exprs.begin(); i!=exprs.end(); i++) {
+            auto* ref = isSgPntrArrRefExp(*i);
+            auto* fvar = ref==NULL ? NULL : isSgVarRefExp(ref->get_lhs_operand());
+            auto* arr = fvar==NULL ? NULL : isSgVarRefExp(ftc::xf_expr(fvar));
+            if(arr==NULL || !xf_deferred_shape(fvar->get_symbol()->get_type()))
+                throw (std::string)"Unhandled ALLOCATE object; only allocatable arrays are supported";
+            
+            string name = fvar->get_symbol()->get_name().getString();
+            auto subs = isSgExprListExp(ref->get_rhs_operand())->get_expressions();
+            
+            SgExpression* count = NULL;
+            for(int d = 0; d<subs.size(); d++) {
+                SgExpression* lower = NULL;
+                SgExpression* upper = NULL;
+                if(isSgSubscriptExpression(subs[d])) {
+                    auto* sub = isSgSubscriptExpression(subs[d]);
+                    lower = isSgNullExpression(sub->get_lowerBound()) ? buildIntVal(1) : ftc::xf_expr(sub->get_lowerBound());
+                    upper = ftc::xf_expr(sub->get_upperBound());
+                }else {
+                    lower = buildIntVal(1);
+                    upper = ftc::xf_expr(subs[d]);
+                }
+                
+                auto* lb = buildVarRefExp(SgName(xf_alloc_bound(name, "lb", d)));
+                auto* n  = buildVarRefExp(SgName(xf_alloc_bound(name, "n", d)));
+                SgExpression* extent = NULL;
+                if(isSgIntVal(lower))
+                     extent = xf_index_add(upper, buildIntVal(1 - isSgIntVal(lower)->get_value()));
+                else extent = xf_index_add(xf_index_sub(upper, deepCopy(lower)), buildIntVal(1));
+                
+                xf_appendStatement(buildExprStatement(buildAssignOp(lb, lower)));
+                if(isSgIntVal(extent) && isSgIntVal(extent)->get_value()<0)
+                    extent = buildIntVal(0);
+                xf_appendStatement(buildExprStatement(buildAssignOp(n, extent)));
+                
+                //fortran gives an upper bound below the lower an extent of 0.
+                if(!isSgIntVal(extent)) {
+                    xf_appendStatement(buildIfStmt(
+                        buildLessThanOp(deepCopy(n), buildIntVal(0)),
+                        buildExprStatement(buildAssignOp(deepCopy(n), buildIntVal(0))),
+                        NULL
+                    ));
+                }
+                
+                count = count==NULL ? deepCopy(n) : xf_index_mul(count, deepCopy(n));
+            }
+            
+            SgType* type = xf_elem_type(arr);
+            xf_appendStatement(buildExprStatement(buildAssignOp(
+                arr,
+                buildCastExp(
+                    buildFunctionCallExp(
+                        buildFunctionRefExp(SgName("ftc__alloc")),
+                        buildExprListExp(xf_index_mul(buildSizeOfOp(type), count))
+                    ),
+                    buildPointerType(type)
+                )
+            )));
+        }
+        
+        auto* stat = alloc->get_stat_expression();
+        if(stat!=NULL && !isSgNullExpression(stat))
+            xf_appendStatement(buildExprStatement(buildAssignOp(ftc::xf_expr(stat), buildIntVal(0))));
+    }
+    
+    void xf_deallocate(SgDeallocateStatement* dealloc) {
+        assert(dealloc!=NULL);
+        
+        #if DEBUG
+            cout << "xf_deallocate(.)" << endl;
+        #endif
+        
+        includes.insert(pair<string,bool>("ftc_alloc.h",true));
+        
+        auto exprs = dealloc->get_expr_list()->get_expressions();
+        for(auto i = exprs.begin(); i!=exprs.end(); i++) {
+            auto* fvar = isSgVarRefExp(*i);
+            if(fvar==NULL || !xf_deferred_shape(fvar->get_symbol()->get_type()))
+                throw (std::string)"Unhandled DEALLOCATE object; only allocatable arrays are supported";
+            
+            string name = fvar->get_symbol()->get_name().getString();
+            auto* arr = ftc::xf_expr(fvar);
+            
+            xf_appendStatement(buildExprStatement(
+                buildFunctionCallExp(buildFunctionRefExp(SgName("ftc__free")), buildExprListExp(arr))
+            ));
+            xf_appendStatement(buildExprStatement(buildAssignOp(deepCopy(arr), buildIntVal(0))));
+            
+            int rank = isSgArrayType(fvar->get_symbol()->get_type())->get_dim_info()->get_expressions().size();
+            for(int d = 0; d<rank; d++)
+                xf_appendStatement(buildExprStatement(buildAssignOp(buildVarRefExp(SgName(xf_alloc_bound(name, "n", d))), buildIntVal(0))));
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+namespace ftc {
+    //unit of a READ/WRITE statement, '*' being the given preconnected unit. anything other than
+    //a constant or a variable is evaluated once, into a temporary.
+    SgExpression* xf_io_unit(SgExpression* unit, int preconnected) {
+        if(isSgAsteriskShapeExp(unit)) return buildIntVal(preconnected);
+        
+        auto* ret = xf_expr(unit);
+        if(isSgValueExp(ret) || isSgVarRefExp(ret)) return ret;
+        
+        string name = genForVariableName("__funit");
+        xf_appendStatement(buildVariableDeclaration(SgName(name), buildIntType(), buildAssignInitializer(ret)));
+        return buildVarRefExp(SgName(name));
+    }
+    
+    //ftc__read_* call reading list-directed input into the item 'expr' from 'unit'.
+    SgExpression* xf_read_item(SgExpression* unit, SgExpression* expr) {
+        SgType* type = expr->get_type();
+        if(xf_rank(expr)>0)
+            throw (string)"Whole array READ items are not handled in xf_read_item";
+        
+        auto* nexp = xf_expr(expr);
+        vector<SgExpression*> args;
+        args.push_back(deepCopy(unit));
+        
+        string fn;
+        if(isSgTypeString(type)) {
+            //blank padded to the declared length; nul terminated for len=*.
+            auto* len = isSgTypeString(type)->get_lengthExpression();
+            args.push_back(nexp);
+            if(len==NULL || isSgAsteriskShapeExp(len) || isSgNullExpression(len))
+                 args.push_back(buildIntVal(-1));
+            else args.push_back(xf_expr(len));
+            return buildFunctionCallExp(SgName("ftc__read_string"), buildVoidType(), buildExprListExp(args));
+        }
+        
+        if(isSgPointerDerefExp(nexp))
+             nexp = isSgPointerDerefExp(nexp)->get_operand();
+        else nexp = buildAddressOfOp(nexp);
+        args.push_back(nexp);
+        
+        if(isSgTypeChar(type)) {
+            args.push_back(buildIntVal(1));
+            return buildFunctionCallExp(SgName("ftc__read_string"), buildVoidType(), buildExprListExp(args));
+        }
+        
+        int kind = xf_kind(type);
+        if     (isSgTypeInt  (type) && kind==4) fn = "ftc__read_int";
+        else if(isSgTypeInt  (type) && kind==8) fn = "ftc__read_long";
+        else if(isSgTypeFloat(type) && kind==4) fn = "ftc__read_float";
+        else if((isSgTypeFloat(type) || isSgTypeDouble(type)) && kind==8) fn = "ftc__read_double";
+        else {
+            cout << type->sage_class_name() << endl;
+            throw (string)"Unhandled READ item type in xf_read_item";
+        }
+        return buildFunctionCallExp(SgName(fn), buildVoidType(), buildExprListExp(args));
+    }
+    
+    //ftc__write_* call adding the value of 'expr' to the record being written on 'unit'.
+    SgExpression* xf_write_item(SgExpression* unit, SgExpression* expr) {
+        SgType* type = expr->get_type();
+        
+        auto* nexp = xf_expr(expr);
+        vector<SgExpression*> args;
+        args.push_back(deepCopy(unit));
+        args.push_back(nexp);
+        
+        if(isSgTypeString(type)) {
+            auto* len = isSgTypeString(type)->get_lengthExpression();
+            if(len==NULL || isSgAsteriskShapeExp(len) || isSgNullExpression(len))
+                 args.push_back(buildIntVal(-1));
+            else args.push_back(xf_expr(len));
+            return buildFunctionCallExp(SgName("ftc__write_string"), buildVoidType(), buildExprListExp(args));
+        }
+        if(isSgTypeChar(type)) {
+            args[1] = buildAddressOfOp(nexp);
+            args.push_back(buildIntVal(1));
+            return buildFunctionCallExp(SgName("ftc__write_string"), buildVoidType(), buildExprListExp(args));
+        }
+        
+        string fn;
+        if     (isSgTypeInt  (type)) fn = xf_kind(type)==8 ? "ftc__write_long"   : "ftc__write_int";
+        else if(isSgTypeFloat(type) || isSgTypeDouble(type)) fn = xf_kind(type)==8 ? "ftc__write_double" : "ftc__write_float";
+        else {
+            cout << type->sage_class_name() << endl;
+            throw (string)"Unhandled WRITE item type in xf_write_item";
+        }
+        return buildFunctionCallExp(SgName(fn), buildVoidType(), buildExprListExp(args));
+    }
+    
+    //suffix of the ftc_file_io.h vector entry points for a C element type; "" if there are none.
+    string xf_io_suffix(SgType* type) {
+        type = type->stripType(SgType::STRIP_MODIFIER_TYPE);
+        if(isSgTypeInt(type))    return "ints";
+        if(isSgTypeLong(type))   return "longs";
+        if(isSgTypeFloat(type))  return "floats";
+        if(isSgTypeDouble(type)) return "doubles";
+        return "";
+    }
+    
+    //io list item transferred by one vector call: pointer to its first element, number of
+    //elements (not positive for none) and the stride between them.
+    struct IoVector {
+        SgExpression* first;
+        SgExpression* count;
+        SgExpression* stride;
+        SgType* type; //C element type
+        
+        //for an implied DO: its variable, first value and step; counter is NULL otherwise.
+        SgExpression* counter;
+        SgExpression* start;
+        SgExpression* step;
+    };
+    
+    //max(count,0).
+    SgExpression* xf_nonnegative(SgExpression* count) {
+        if(isSgIntVal(count))
+            return buildIntVal(std::max(isSgIntVal(count)->get_value(), 0));
+        return buildConditionalExp(buildGreaterThanOp(deepCopy(count), buildIntVal(0)), deepCopy(count), buildIntVal(0));
+    }
+    
+    //an implied DO done by a vector call still leaves its variable as the loop would have:
+    //l + max(count,0)*s.
+    void xf_implied_final(const IoVector& vec) {
+        if(vec.counter==NULL) return;
+        auto* final = xf_index_add(deepCopy(vec.start), xf_index_mul(xf_nonnegative(vec.count), deepCopy(vec.step)));
+        xf_appendStatement(buildExprStatement(buildAssignOp(vec.counter, final)));
+    }
+    
+    bool xf_uses_var(SgExpression* expr, const string& name) {
+        if(isSgVarRefExp(expr))
+            return isSgVarRefExp(expr)->get_symbol()->get_name().getString()==name;
+        
+        auto children = expr->get_traversalSuccessorContainer();
+        for(auto i = children.begin(); i!=children.end(); i++)
+            if(isSgExpression(*i) && xf_uses_var(isSgExpression(*i), name)) return true;
+        return false;
+    }
     
-    void xf_fortran_do(SgFortranDo* fdo) {
-        assert(fdo!=NULL);
+    //implied DO (a(...,i+c,...), i=l,u,s) of a single array element, the do variable i used in
+    //one subscript only, as i, i+c or i-c: a vector with a stride of s elements of that
+    //dimension.
+    bool xf_implied_vector(SgImpliedDo* ido, IoVector& ret) {
+        auto objects = ido->get_object_list()->get_expressions();
+        auto* init = isSgAssignOp(ido->get_do_var_initialization());
+        if(objects.size()!=1 || init==NULL || !isSgVarRefExp(init->get_lhs_operand())) return false;
+        string var = isSgVarRefExp(init->get_lhs_operand())->get_symbol()->get_name().getString();
         
-        #if DEBUG
-            cout << "xf_fortran_do(.)" << endl;
-        #endif
+        auto* ref = isSgPntrArrRefExp(objects[0]);
+        if(ref==NULL || xf_rank(ref)>0 || !isSgVarRefExp(ref->get_lhs_operand())) return false;
         
-        auto* do_init = fdo->get_initialization();
-        if(!isSgAssignOp(do_init)) {
-            throw (std::string)"Unhandled FortranDo Initialisation expression in ftc::xf_fortran_do";
-            return;
+        auto subs = isSgExprListExp(ref->get_rhs_operand())->get_expressions();
+        int dim = -1;
+        for(int d = 0; d<subs.size(); d++) {
+            if(!xf_uses_var(subs[d], var)) continue;
+            if(dim>=0) return false;
+            dim = d;
+            
+            auto* binop = isSgBinaryOp(subs[d]);
+            if(isSgVarRefExp(subs[d])) continue;
+            if(!(isSgAddOp(binop) || isSgSubtractOp(binop))
+            || !isSgVarRefExp(binop->get_lhs_operand()) || xf_uses_var(binop->get_rhs_operand(), var))
+                return false;
         }
+        if(dim<0) return false;
         
-        auto* for_init_exp = isSgAssignOp(ftc::xf_expr(do_init));
-        auto* counter = for_init_exp->get_lhs_operand();
-        if(!isSgVarRefExp(counter)) {
-            throw (std::string)"Unhandled FortranDo Initialisation 2; assignOp LHS was not a variable";
-            return;
-        }
-        auto* for_init = buildExprStatement(for_init_exp);
-        xf_appendStatement(for_init);
+        auto* arr = isSgVarRefExp(xf_expr(ref->get_lhs_operand()));
+        if(arr==NULL || !arr->get_symbol()->get_declaration()->attributeExists("dim")) return false;
+        auto* dimattr = static_cast<ArrDimAttribute*>(arr->get_symbol()->get_declaration()->getAttribute("dim"));
         
-        //
+        ret.type = xf_elem_type(arr);
+        if(xf_io_suffix(ret.type).empty()) return false;
         
-        auto* do_bound = fdo->get_bound();
-        string bound_name = genForVariableName("__fbound");
-        SgType* bound_type = ftc::xf_type(do_bound->get_type());
-        auto* bound_exp = ftc::xf_expr(do_bound);
-        auto* bound_decl = buildVariableDeclaration(
-            SgName(bound_name), bound_type,
-            buildAssignInitializer(bound_exp)
-        );
-        xf_appendStatement(bound_decl);
+        auto* first = xf_expr(init->get_rhs_operand());
+        auto* last = xf_expr(ido->get_last_val());
+        auto* fstep = ido->get_increment();
+        SgExpression* step = fstep==NULL || isSgNullExpression(fstep) ? NULL : xf_expr(fstep);
         
-        auto* do_step = fdo->get_increment();
-        SgStatement* for_test = NULL;
+        ret.counter = xf_expr(init->get_lhs_operand());
+        ret.start = deepCopy(first);
+        ret.step = step==NULL ? buildIntVal(1) : deepCopy(step);
         
-        if(isSgNullExpression(do_step)) {
-            for_test = buildExprStatement(
-                buildLessOrEqualOp(counter, buildVarRefExp(SgName(bound_name)))
-            );
-        }else {
-            string limit_name = genForVariableName("__fdir");
-            auto* limit_decl = buildVariableDeclaration(
-                SgName(limit_name), buildIntType(),
-                buildAssignInitializer(
-                    buildLessOrEqualOp(counter,buildVarRefExp(SgName(bound_name)))
-                )
-            ); 
-            xf_appendStatement(limit_decl);
-                   
-            for_test = buildExprStatement(
-                buildConditionalExp(
-                    buildVarRefExp(SgName(limit_name)),
-                    buildLessOrEqualOp(counter, buildVarRefExp(SgName(bound_name))),
-                    buildGreaterOrEqualOp(counter, buildVarRefExp(SgName(bound_name)))
-                )
-            );
+        vector<SgExpression*> indices;
+        for(int d = 0; d<subs.size(); d++) {
+            if(d!=dim) {
+                indices.push_back(xf_expr(subs[d]));
+                continue;
+            }
+            SgExpression* index = deepCopy(first);
+            if(isSgAddOp(subs[d]))
+                index = xf_index_add(index, xf_expr(isSgAddOp(subs[d])->get_rhs_operand()));
+            else if(isSgSubtractOp(subs[d]))
+                index = xf_index_sub(index, xf_expr(isSgSubtractOp(subs[d])->get_rhs_operand()));
+            indices.push_back(index);
         }
-
-        //
+        ret.first = buildAddressOfOp(xf_arr_ref(arr, indices));
         
-        SgExpression* for_step = NULL;
-        if(isSgNullExpression(do_step)) {
-            for_step = buildPlusPlusOp(counter);
-            #if DEBUG
-                cout << ".. using default step (++)" << endl;
-            #endif
-        }else {
-            string step_name = genForVariableName("__fstep");
-            SgType* step_type = ftc::xf_type(do_bound->get_type());
-            auto* step_exp = ftc::xf_expr(do_step);
-            auto* step_decl = buildVariableDeclaration(
-                SgName(step_name), step_type,
-                buildAssignInitializer(step_exp)
-            );
-            xf_appendStatement(step_decl);
-            
-            for_step = buildPlusAssignOp(counter, buildVarRefExp(SgName(step_name)));
+        //(u - l + s)/s
+        ret.count = xf_index_sub(last, first);
+        if(step==NULL)
+             ret.count = xf_index_add(ret.count, buildIntVal(1));
+        else ret.count = xf_fold(buildDivideOp(xf_index_add(ret.count, deepCopy(step)), deepCopy(step)));
+        
+        ret.stride = xf_index_mul(step==NULL ? buildIntVal(1) : step, dim==0 ? NULL : deepCopy(dimattr->sizes[dim-1]));
+        return true;
+    }
+    
+    //a whole array with known size, or a section ranging over one dimension.
+    bool xf_section_vector(SgExpression* expr, IoVector& ret) {
+        auto section = xf_array_section(expr, true);
+        ret.type = xf_elem_type(section.arr);
+        ret.counter = NULL;
+        if(xf_io_suffix(ret.type).empty()) return false;
+        
+        if(isSgVarRefExp(expr)) {
+            ret.first = section.arr;
+            ret.count = xf_array_size(section.arr);
+            ret.stride = buildIntVal(1);
+            return ret.count!=NULL;
         }
         
+        if(section.dims.size()!=1 || section.counts[0]==NULL) return false;
+        
+        auto* dimattr = static_cast<ArrDimAttribute*>(section.arr->get_symbol()->get_declaration()->getAttribute("dim"));
+        int dim = section.dims[0];
+        
+        auto indices = section.indices;
+        indices[dim] = section.lowers[0];
+        ret.first = buildAddressOfOp(xf_arr_ref(section.arr, indices));
+        ret.count = section.counts[0];
+        ret.stride = xf_index_mul(section.strides[0]==NULL ? buildIntVal(1) : section.strides[0],
+                                  dim==0 ? NULL : deepCopy(dimattr->sizes[dim-1]));
+        return true;
+    }
+    
+    void xf_io_item(SgExpression* unit, SgExpression* expr, bool read);
+    
+    //an implied DO that isn't a vector: a loop over its items.
+    void xf_implied_loop(SgExpression* unit, SgImpliedDo* ido, bool read) {
+        auto* init = isSgAssignOp(ido->get_do_var_initialization());
+        if(init==NULL)
+            throw (string)"Unhandled implied DO initialisation in xf_implied_loop";
+        
+        auto* fstep = ido->get_increment();
+        auto* step = fstep==NULL || isSgNullExpression(fstep) ? buildIntVal(1) : xf_expr(fstep);
+        if(!isSgIntVal(step) || isSgIntVal(step)->get_value()==0)
+            throw (string)"Implied DO with a non constant step in xf_implied_loop";
+        int s = isSgIntVal(step)->get_value();
+        
+        auto* counter = xf_expr(init->get_lhs_operand());
+        auto* last = xf_expr(ido->get_last_val());
+        
         auto* body = buildBasicBlock();
-        auto* forl = buildForStatement(buildNullStatement(),for_test,for_step,body);
+        auto* forl = buildForStatement(
+            buildExprStatement(buildAssignOp(counter, xf_expr(init->get_rhs_operand()))),
+            buildExprStatement(s>0 ? (SgExpression*)buildLessOrEqualOp(deepCopy(counter), last)
+                                   : (SgExpression*)buildGreaterOrEqualOp(deepCopy(counter), last)),
+            s==1 ? (SgExpression*)buildPlusPlusOp(deepCopy(counter)) : (SgExpression*)buildPlusAssignOp(deepCopy(counter), step),
+            body
+        );
         xf_appendStatement(forl);
-                
-        xf_block(fdo->get_body(), body, NULL);
+        
+        xf_pushScopeStack(body);
+        auto objects = ido->get_object_list()->get_expressions();
+        for(auto i = objects.begin(); i!=objects.end(); i++)
+            xf_io_item(unit, *i, read);
+        xf_popScopeStack();
     }
-}
-
-//--------------------------------------------------------------------------------------------------
-
-namespace ftc {
-    string xf_format(SgExpression* expr) {
-        assert(expr!=NULL);
+    
+    //statements transferring an item of a list-directed io list. arrays and implied DOs of
+    //array elements are one ftc__read_<T>s/ftc__write_<T>s call where they can be.
+    void xf_io_item(SgExpression* unit, SgExpression* expr, bool read) {
+        IoVector vec;
+        auto* ido = isSgImpliedDo(expr);
+        
+        if(ido!=NULL ? xf_implied_vector(ido, vec) : xf_rank(expr)>0 && xf_section_vector(expr, vec)) {
+            string fn = (read ? "ftc__read_" : "ftc__write_") + xf_io_suffix(vec.type);
+            xf_appendStatement(buildExprStatement(buildFunctionCallExp(
+                SgName(fn), buildVoidType(),
+                buildExprListExp(deepCopy(unit), vec.first, vec.count, vec.stride)
+            )));
+            xf_implied_final(vec);
+            return;
+        }
+        
+        if(ido!=NULL)
+            xf_implied_loop(unit, ido, read);
+        else if(xf_rank(expr)>0)
+            throw (string)"Unhandled array section in list-directed I/O in xf_io_item";
+        else
+            xf_appendStatement(buildExprStatement(read ? xf_read_item(unit, expr) : xf_write_item(unit, expr)));
+    }
+    
+    //storage of an unformatted READ/WRITE item and its size in bytes: the variable, or the
+    //whole of a contiguous array. a WRITE item that isn't a variable is evaluated into a
+    //temporary first.
+    pair<SgExpression*,SgExpression*> xf_unformatted_item(SgExpression* expr, bool write) {
         SgType* type = expr->get_type();
-        if     (isSgTypeString(type)) return (string)"%s";
-        else if(isSgTypeInt   (type)) return (string)"%d";
-        else if(isSgTypeFloat (type)) {
-            auto* kind = type->get_type_kind();
-            if(kind!=NULL && isSgIntVal(kind) && isSgIntVal(kind)->get_value()==8)
-                 return (string)"%lf";
-            else return (string)"%f";
+        
+        //(a(i), i=l,u) over consecutive elements.
+        if(isSgImpliedDo(expr)) {
+            IoVector vec;
+            if(!xf_implied_vector(isSgImpliedDo(expr), vec) || !isSgIntVal(vec.stride) || isSgIntVal(vec.stride)->get_value()!=1)
+                throw (string)"Implied DO over non consecutive elements in unformatted I/O in xf_unformatted_item";
+            
+            //the item's pointer and size don't depend on the variable, so it can be set first.
+            xf_implied_final(vec);
+            return pair<SgExpression*,SgExpression*>(vec.first, xf_index_mul(xf_nonnegative(vec.count), buildSizeOfOp(vec.type)));
+        }
+        
+        if(xf_rank(expr)>0) {
+            SgExpression* first = NULL;
+            SgType* elem_type = NULL;
+            SgExpression* count = NULL;
+            if(!xf_contiguous(expr, first, elem_type, count))
+                throw (string)"Non contiguous array in unformatted I/O in xf_unformatted_item";
+            return pair<SgExpression*,SgExpression*>(first, xf_index_mul(count, buildSizeOfOp(elem_type)));
+        }
+        
+        auto* nexp = xf_expr(expr);
+        if(isSgTypeString(type)) {
+            auto* len = isSgTypeString(type)->get_lengthExpression();
+            if(len==NULL || isSgAsteriskShapeExp(len) || isSgNullExpression(len))
+                throw (string)"Character item of unknown length in unformatted I/O in xf_unformatted_item";
+            return pair<SgExpression*,SgExpression*>(nexp, xf_expr(len));
+        }
+        
+        if(!(isSgVarRefExp(nexp) || isSgPntrArrRefExp(nexp) || isSgPointerDerefExp(nexp))) {
+            if(!write)
+                throw (string)"READ item is not a variable in xf_unformatted_item";
+            
+            string name = genForVariableName("__fout");
+            xf_appendStatement(buildVariableDeclaration(SgName(name), xf_type(type), buildAssignInitializer(nexp)));
+            nexp = buildVarRefExp(SgName(name));
         }
-        else if(isSgTypeChar  (type)) return (string)"%c";
         
-        cout << type->sage_class_name() << endl;
-        throw (string)"Unhandled expression type in xf_format";
+        auto* size = buildSizeOfOp(xf_type(type));
+        if(isSgPointerDerefExp(nexp))
+             return pair<SgExpression*,SgExpression*>(isSgPointerDerefExp(nexp)->get_operand(), size);
+        else return pair<SgExpression*,SgExpression*>(buildAddressOfOp(nexp), size);
+    }
+    
+    //true for the READ/WRITE of an unformatted (or stream) unit.
+    bool xf_unformatted(SgExpression* format) {
+        if(format==NULL || isSgNullExpression(format)) return true;
+        if(!isSgAsteriskShapeExp(format))
+            throw (string)"Only list-directed and unformatted I/O is handled, in xf_unformatted";
+        return false;
     }
 }
 
@@ -1205,275 +3577,339 @@ namespace ftc {
     then passing the state around.
 */
 
+namespace ftc {
+    XfOptions xf_options;
+    
+    string xf_options_signature() {
+        string ret;
+        if(!xf_options.restrict_args) ret.append(" no-restrict");
+        if(xf_options.copy_scalars) ret.append(" copy-scalars");
+        return ret;
+    }
+}
+
 namespace ftc {
     map<string, SgFile*>* module_map;
     vector<pair<SgGlobal*,string>>* use_statements;
 }
 
-void ftc::XfVisitor::preOrderVisit(SgNode* n) {
-    if(sync!=NULL) return;
+bool ftc::XfVisitor::preOrderVisit(SgNode* n) {
+    switch(n->variantT()) {
+        //ignore list.
+        case V_SgGlobal:
+        case V_SgContainsStatement:
+        case V_SgClassDefinition:
+        case V_SgImplicitStatement:
+        case V_SgBasicBlock:
+            return true;
+            
+        default: break;
+    }
     
-    //ignore list.
-    if(isSgGlobal(n)) return;
-    if(isSgContainsStatement(n)) return;
-    if(isSgClassDefinition(n)) return;
-    if(isSgImplicitStatement(n)) return;
-    if(isSgBasicBlock(n)) return;
+    time_report.count(n);
        
     #if DEBUG     
         cout << "visit " << n->sage_class_name() << endl;
     #endif
     
-    if(isSgModuleStatement(n)) {
-        auto* mod = isSgModuleStatement(n);
-    
-        //retrieve the C file currently being created in translation.
-        auto* c_file = getEnclosingFileNode(topScopeStack());
-        
-        (*module_map)[mod->get_name().getString()] = c_file;
-    
-        #if DEBUG
-            cout << "XfVisitor::preOrderVisit::module_stmt (> "
-                 << c_file->get_unparse_output_filename() << " defines module "
-                 << mod->get_name().getString() << endl;
-        #endif
-    
-        //DON'T SYNC, want to continue to the body.
-        return;
-    }
-    
-    if(isSgUseStatement(n)) {
-        auto* use = isSgUseStatement(n);
-
-        //retrieve the C file currently being created in translation.
-        auto* c_gscope = getGlobalScope(topScopeStack());
-        
-        use_statements->push_back(pair<SgGlobal*,string>(c_gscope, use->get_name().getString()));
-
-        #if DEBUG
-            cout << "XfVisitor::preOrderVisit::use_stmt (> "
-                 << getEnclosingFileNode(c_gscope)->get_unparse_output_filename()
-                 << " uses module " << use->get_name().getString() << endl;
-        #endif
-
-        sync = n;
-        return;
-    }
-           
-    if(isSgProcedureHeaderStatement(n)) {
-        xf_fn_decl(isSgProcedureHeaderStatement(n));
-        sync = n;
-        return;
-    }
-    
-    if(isSgVariableDeclaration(n)) {
-        xf_var_decl(isSgVariableDeclaration(n), arguments);
-        sync = n;
-        return;
-    }
-    
-    if(isSgExprStatement(n)) {
-        #if DEBUG
-            cout << "XfVisitor::preOrderVisit::expr_stmt" << endl;
-        #endif
-        auto* expr = ftc::xf_expr(isSgExprStatement(n)->get_expression());
-        xf_appendStatement(buildExprStatement(expr));
-        sync = n;
-        return;
-    }
-    
-    if(isSgFortranDo(n)) {
-        xf_fortran_do(isSgFortranDo(n));
-        sync = n;
-        return;
-    }
-    
-    //ASSUMPTION: only functions have return statements; always in the format 'return' only.
-    // --edit: Need to handle return statement in subprocedure :(
-    if(isSgReturnStmt(n)) {
-        #if DEBUG
-            cout << "XfVisitor::preOrderVisit::return_stmt" << endl;
-        #endif
-        
-        auto* fn_decl = getEnclosingFunctionDeclaration(n,true);
-        assert(fn_decl!=NULL);
-        assert(isSgProcedureHeaderStatement(fn_decl));
+    switch(n->variantT()) {
+        case V_SgModuleStatement: {
+            auto* mod = isSgModuleStatement(n);
         
-        auto* proc_h = isSgProcedureHeaderStatement(fn_decl);
-        if(proc_h->isFunction())
-            xf_appendStatement(buildReturnStmt(buildVarRefExp(SgName("__retv"))));
-        else
-            xf_appendStatement(buildReturnStmt(buildNullExpression()));
+            //retrieve the C file currently being created in translation.
+            auto* c_file = getEnclosingFileNode(topScopeStack());
+            
+            (*module_map)[mod->get_name().getString()] = c_file;
         
-        sync = n;
-        return;
-    }
-    
-    if(isSgIfStmt(n)) {
-        #if DEBUG
-            cout << "XfVisitor::preOrderVisit::if_stmt" << endl;
-        #endif
-        auto* ifst = isSgIfStmt(n);
+            #if DEBUG
+                cout << "XfVisitor::preOrderVisit::module_stmt (> "
+                     << c_file->get_unparse_output_filename() << " defines module "
+                     << mod->get_name().getString() << endl;
+            #endif
         
-        assert(isSgExprStatement(ifst->get_conditional()));
-        assert(isSgBasicBlock(ifst->get_true_body()));
-        if(!isSgNullStatement(ifst->get_false_body()))
-            assert(isSgBasicBlock(ifst->get_false_body()));
-            
-        auto* cond = isSgExprStatement(ifst->get_conditional())->get_expression();
-        auto* if_cond = xf_expr(cond);
-            
-        auto* if_true = buildBasicBlock();
+            //want to continue to the body.
+            return true;
+        }
         
-        SgStatement* if_false = NULL;
-        if(isSgNullStatement(ifst->get_false_body()))
-            if_false = buildNullStatement();
-        else
-            if_false = buildBasicBlock();
+        case V_SgUseStatement: {
+            auto* use = isSgUseStatement(n);
+
+            //retrieve the C file currently being created in translation.
+            auto* c_gscope = getGlobalScope(topScopeStack());
             
-        auto* nif = buildIfStmt(
-            if_cond,
-            if_true,
-            if_false
-        );
-        appendStatement(nif);
-        
-        xf_block(isSgBasicBlock(ifst->get_true_body()), if_true);
-        if(!isSgNullStatement(ifst->get_false_body()))
-            xf_block(isSgBasicBlock(ifst->get_false_body()), isSgBasicBlock(if_false));
-                    
-        sync = n;
-        return;
-    }
-    
-    if(isSgPrintStatement(n)) {
-        auto* print = isSgPrintStatement(n);
-        auto* lhs = print->get_format();
-        assert(isSgAsteriskShapeExp(lhs));
+            use_statements->push_back(pair<SgGlobal*,string>(c_gscope, use->get_name().getString()));
+
+            #if DEBUG
+                cout << "XfVisitor::preOrderVisit::use_stmt (> "
+                     << getEnclosingFileNode(c_gscope)->get_unparse_output_filename()
+                     << " uses module " << use->get_name().getString() << endl;
+            #endif
+
+            return false;
+        }
+               
+        case V_SgProcedureHeaderStatement: {
+            xf_fn_decl(isSgProcedureHeaderStatement(n));
+            return false;
+        }
         
-        string format = "";
+        case V_SgVariableDeclaration: {
+            xf_var_decl(isSgVariableDeclaration(n), arguments);
+            return false;
+        }
         
-        vector<SgExpression*> ret_args;
-        auto* stmts = print->get_io_stmt_list();
-        auto exprs = stmts->get_expressions();
+        case V_SgExprStatement: {
+            #if DEBUG
+                cout << "XfVisitor::preOrderVisit::expr_stmt" << endl;
+            #endif
+            auto* fexpr = isSgExprStatement(n)->get_expression();
+            if(isSgAssignOp(fexpr) && xf_rank(isSgAssignOp(fexpr)->get_lhs_operand())>0) {
+                xf_array_assign(isSgAssignOp(fexpr));
+                return false;
+            }
+            
+            auto* expr = ftc::xf_expr(fexpr);
+            xf_appendStatement(buildExprStatement(expr));
+            return false;
+        }
         
-        for(auto i = exprs.begin(); i!=exprs.end(); i++) {
-            auto* exp = *i;
-            format.append(xf_format(exp));
-            ret_args.push_back(xf_expr(exp));
+        case V_SgFortranDo:
+        case V_SgFortranNonblockedDo: {
+            xf_fortran_do(isSgFortranDo(n));
+            return false;
         }
-        format.append("\\n");
         
-        ret_args.insert(ret_args.begin(),buildStringVal(format));
+        case V_SgAllocateStatement: {
+            xf_allocate(isSgAllocateStatement(n));
+            return false;
+        }
         
-        auto* rprint = buildFunctionCallExp(
-            buildFunctionRefExp("printf"),
-            buildExprListExp(ret_args)
-        );
-        appendStatement(buildExprStatement(rprint));
+        case V_SgDeallocateStatement: {
+            xf_deallocate(isSgDeallocateStatement(n));
+            return false;
+        }
         
-        includes.insert(pair<string,bool>("stdio.h",true));
-    
-        sync = n;
-        return;
-    }
-    
-    if(isSgOpenStatement(n)) {
-        auto* open = isSgOpenStatement(n);
-        auto* file = open->get_file();
-        auto* fileid = open->get_unit();
+        //ASSUMPTION: only functions have return statements; always in the format 'return' only.
+        // --edit: Need to handle return statement in subprocedure :(
+        case V_SgReturnStmt: {
+            #if DEBUG
+                cout << "XfVisitor::preOrderVisit::return_stmt" << endl;
+            #endif
+            
+            auto* fn_decl = getEnclosingFunctionDeclaration(n,true);
+            assert(fn_decl!=NULL);
+            assert(isSgProcedureHeaderStatement(fn_decl));
+            
+            auto* proc_h = isSgProcedureHeaderStatement(fn_decl);
+            xf_copy_out();
+            xf_free_locals();
+            if(proc_h->isFunction())
+                xf_appendStatement(buildReturnStmt(buildVarRefExp(SgName("__retv"))));
+            else
+                xf_appendStatement(buildReturnStmt(buildNullExpression()));
+            
+            return false;
+        }
         
-        includes.insert(pair<string,bool>("ftc_file_io.h",true));
+        case V_SgIfStmt: {
+            #if DEBUG
+                cout << "XfVisitor::preOrderVisit::if_stmt" << endl;
+            #endif
+            auto* ifst = isSgIfStmt(n);
+            
+            assert(isSgExprStatement(ifst->get_conditional()));
+            assert(isSgBasicBlock(ifst->get_true_body()));
+            if(!isSgNullStatement(ifst->get_false_body()))
+                assert(isSgBasicBlock(ifst->get_false_body()));
+                
+            auto* cond = isSgExprStatement(ifst->get_conditional())->get_expression();
+            auto* if_cond = xf_expr(cond);
+                
+            auto* if_true = buildBasicBlock();
+            
+            SgStatement* if_false = NULL;
+            if(isSgNullStatement(ifst->get_false_body()))
+                if_false = buildNullStatement();
+            else
+                if_false = buildBasicBlock();
+                
+            auto* nif = buildIfStmt(
+                if_cond,
+                if_true,
+                if_false
+            );
+            appendStatement(nif);
+            
+            xf_block(isSgBasicBlock(ifst->get_true_body()), if_true);
+            if(!isSgNullStatement(ifst->get_false_body()))
+                xf_block(isSgBasicBlock(ifst->get_false_body()), isSgBasicBlock(if_false));
+                        
+            return false;
+        }
         
-        vector<SgExpression*> ret_args;
-        ret_args.push_back(xf_expr(fileid));
-        ret_args.push_back(xf_expr(file));
+        case V_SgPrintStatement: {
+            auto* print = isSgPrintStatement(n);
+            auto* lhs = print->get_format();
+            assert(isSgAsteriskShapeExp(lhs));
+            
+            //list-directed, as WRITE on unit 6.
+            auto* unit = buildIntVal(6);
+            auto exprs = print->get_io_stmt_list()->get_expressions();
+            for(auto i = exprs.begin(); i!=exprs.end(); i++)
+                xf_io_item(unit, *i, false);
+            
+            auto* rend = buildFunctionCallExp(
+                buildFunctionRefExp("ftc__write_end"),
+                buildExprListExp(unit)
+            );
+            appendStatement(buildExprStatement(rend));
+            
+            includes.insert(pair<string,bool>("ftc_file_io.h",true));
         
-        auto* ropen = buildFunctionCallExp(
-            buildFunctionRefExp("ftc__open_file"),
-            buildExprListExp(ret_args)
-        );
-        appendStatement(buildExprStatement(ropen));
+            return false;
+        }
         
-        sync = n;
-        return;
-    }
-    
-    if(isSgCloseStatement(n)) {
-        auto* close = isSgCloseStatement(n);
+        case V_SgOpenStatement: {
+            auto* open = isSgOpenStatement(n);
+            
+            includes.insert(pair<string,bool>("ftc_file_io.h",true));
+            
+            //specifiers not given are passed as NULL.
+            auto spec = [](SgExpression* expr) -> SgExpression* {
+                if(expr==NULL || isSgNullExpression(expr)) return buildIntVal(0);
+                return xf_expr(expr);
+            };
+            
+            vector<SgExpression*> ret_args;
+            ret_args.push_back(xf_expr(open->get_unit()));
+            ret_args.push_back(spec(open->get_file()));
+            ret_args.push_back(spec(open->get_status()));
+            ret_args.push_back(spec(open->get_access()));
+            ret_args.push_back(spec(open->get_form()));
+            ret_args.push_back(spec(open->get_action()));
+            ret_args.push_back(spec(open->get_position()));
+            
+            auto* ropen = buildFunctionCallExp(
+                buildFunctionRefExp("ftc__open"),
+                buildExprListExp(ret_args)
+            );
+            appendStatement(buildExprStatement(ropen));
+            
+            return false;
+        }
         
-        auto* fileid = close->get_unit();
+        case V_SgCloseStatement: {
+            auto* close = isSgCloseStatement(n);
+            
+            auto* fileid = close->get_unit();
 
-        vector<SgExpression*> ret_args;
-        ret_args.push_back(xf_expr(fileid));
-        
-        auto* rclose = buildFunctionCallExp(
-            buildFunctionRefExp("ftc__close_file"),
-            buildExprListExp(ret_args)
-        );
-        appendStatement(buildExprStatement(rclose));
-        
-        includes.insert(pair<string,bool>("ftc_file_io.h",true));
-        
-        sync = n;
-        return;
-    }
-    
-    if(isSgReadStatement(n)) {
-        auto* read = isSgReadStatement(n);
-        assert(isSgAsteriskShapeExp(read->get_format()));
-        
-        auto* fileid = read->get_unit();
+            vector<SgExpression*> ret_args;
+            ret_args.push_back(xf_expr(fileid));
+            
+            auto* rclose = buildFunctionCallExp(
+                buildFunctionRefExp("ftc__close_file"),
+                buildExprListExp(ret_args)
+            );
+            appendStatement(buildExprStatement(rclose));
+            
+            includes.insert(pair<string,bool>("ftc_file_io.h",true));
+            
+            return false;
+        }
         
-        string format = "";
+        case V_SgReadStatement: {
+            auto* read = isSgReadStatement(n);
+            auto* unit = xf_io_unit(read->get_unit(), 5);
+            
+            auto* stmts = read->get_io_stmt_list();
+            auto exprs = stmts->get_expressions();
+            
+            includes.insert(pair<string,bool>("ftc_file_io.h",true));
+            
+            if(xf_unformatted(read->get_format())) {
+                //one record, one block of bytes per item. the size of an item can depend on
+                //one read before it (read(u) n, a(1:n)).
+                appendStatement(buildExprStatement(buildFunctionCallExp(
+                    buildFunctionRefExp("ftc__read_record"), buildExprListExp(deepCopy(unit))
+                )));
+                for(auto i = exprs.begin(); i!=exprs.end(); i++) {
+                    auto item = xf_unformatted_item(*i, false);
+                    appendStatement(buildExprStatement(buildFunctionCallExp(
+                        buildFunctionRefExp("ftc__read_data"),
+                        buildExprListExp(deepCopy(unit), item.first, item.second)
+                    )));
+                }
+                appendStatement(buildExprStatement(buildFunctionCallExp(
+                    buildFunctionRefExp("ftc__read_record_end"), buildExprListExp(deepCopy(unit))
+                )));
+                return false;
+            }
+            
+            //list-directed: one typed read per item, in order, so an item can use a value
+            //read before it (read *, n, a(n)); ftc__read_end moves on to the next record.
+            for(auto i = exprs.begin(); i!=exprs.end(); i++)
+                xf_io_item(unit, *i, true);
+            
+            auto* rend = buildFunctionCallExp(
+                buildFunctionRefExp("ftc__read_end"),
+                buildExprListExp(deepCopy(unit))
+            );
+            appendStatement(buildExprStatement(rend));
         
-        vector<SgExpression*> ret_args;
-        auto* stmts = read->get_io_stmt_list();
-        auto exprs = stmts->get_expressions();
+            return false;
+        }
         
-        for(auto i = exprs.begin(); i!=exprs.end(); i++) {
-            auto* exp = *i;
-            format.append(xf_format(exp));
+        case V_SgWriteStatement: {
+            auto* write = isSgWriteStatement(n);
+            auto* unit = xf_io_unit(write->get_unit(), 6);
             
-            auto* nexp = xf_expr(exp);
-            if(isSgPointerDerefExp(nexp))
-                 nexp = isSgPointerDerefExp(nexp)->get_operand();
-            else nexp = buildAddressOfOp(nexp);
+            includes.insert(pair<string,bool>("ftc_file_io.h",true));
+            
+            if(xf_unformatted(write->get_format())) {
+                //one record, its length known before any of it is written.
+                auto exprs = write->get_io_stmt_list()->get_expressions();
+                vector<pair<SgExpression*,SgExpression*>> items;
+                SgExpression* bytes = buildIntVal(0);
+                for(auto i = exprs.begin(); i!=exprs.end(); i++) {
+                    items.push_back(xf_unformatted_item(*i, true));
+                    bytes = xf_index_add(bytes, deepCopy(items.back().second));
+                }
                 
-            ret_args.push_back(nexp);
+                appendStatement(buildExprStatement(buildFunctionCallExp(
+                    buildFunctionRefExp("ftc__write_record"), buildExprListExp(deepCopy(unit), bytes)
+                )));
+                for(auto i = items.begin(); i!=items.end(); i++)
+                    appendStatement(buildExprStatement(buildFunctionCallExp(
+                        buildFunctionRefExp("ftc__write_data"),
+                        buildExprListExp(deepCopy(unit), i->first, i->second)
+                    )));
+                appendStatement(buildExprStatement(buildFunctionCallExp(
+                    buildFunctionRefExp("ftc__write_record_end"), buildExprListExp(deepCopy(unit))
+                )));
+                return false;
+            }
+            
+            //list-directed: the record is built up by one call per item (or vector of
+            //items) and written out by ftc__write_end.
+            auto exprs = write->get_io_stmt_list()->get_expressions();
+            for(auto i = exprs.begin(); i!=exprs.end(); i++)
+                xf_io_item(unit, *i, false);
+            
+            auto* rend = buildFunctionCallExp(
+                buildFunctionRefExp("ftc__write_end"),
+                buildExprListExp(deepCopy(unit))
+            );
+            appendStatement(buildExprStatement(rend));
+            
+            return false;
         }
-        format.append("\\n");
-        
-        vector<SgExpression*> get_args;
-        get_args.push_back(xf_expr(fileid));
-        
-        ret_args.insert(ret_args.begin(),buildStringVal(format));
-        ret_args.insert(ret_args.begin(),
-            buildFunctionCallExp(
-                buildFunctionRefExp("ftc__get_file"),
-                buildExprListExp(get_args)
-            )
-        );
-        
-        auto* rprint = buildFunctionCallExp(
-            buildFunctionRefExp("fscanf"),
-            buildExprListExp(ret_args)
-        );
-        appendStatement(buildExprStatement(rprint));
         
-        includes.insert(pair<string,bool>("stdio.h",true));
-        includes.insert(pair<string,bool>("ftc_file_io.h",true));
-    
-        sync = n;
-        return;
+        default: break;
     }
     
     cout << n->sage_class_name() << endl;
     throw (std::string)"XfVisitor::preOrderVisit non handled node type";
-}
-        
-void ftc::XfVisitor::postOrderVisit(SgNode* n) {
-    if(n==sync) sync = NULL;
+    return false;
 }
 
 ///_________________________________________________________________________________________________
@@ -1486,6 +3922,9 @@ SgFile* ftc::xf_file(SgFile* file, SgProject** project, map<string,SgFile*>& mod
     ftc::module_map = &module_map;
     ftc::use_statements = &use_statements;
     
+    //left over if translating the previous file failed part way.
+    loop_stack.clear();
+    
     if(file->get_outputLanguage()!=SgFile::e_Fortran_output_language) {
         throw (std::string)"Input file was not a Fortran file in tcf::xf_file :: SgFile* -> SgProject** -> SgFile*";
         return NULL;
@@ -1547,32 +3986,20 @@ SgFile* ftc::xf_file(SgFile* file, SgProject** project, map<string,SgFile*>& mod
 ///
 
 namespace ftc {
-    class GenVisitor : public AstPrePostProcessing {
-        //used when I want to skip the traversal of an entire sub-tree.
-        //keep ignoring nodes until postOrderVisit is called with the sync node.
-        SgNode* sync;
-        
+    //sub-trees of generated declarations and of blocks are never descended into.
+    class GenVisitor : public PruningTraversal {
     public:
-        GenVisitor() {
-            sync = NULL;
-        }
-
-        void preOrderVisit(SgNode* n);
-        void postOrderVisit(SgNode* n);
+        bool preOrderVisit(SgNode* n);
     };
 }
 
-void ftc::GenVisitor::preOrderVisit(SgNode* n) {
-    if(sync!=NULL) return;
-    
+bool ftc::GenVisitor::preOrderVisit(SgNode* n) {
     //ignore list.
-    if(isSgGlobal(n)) return;
+    if(isSgGlobal(n)) return true;
     
     //want to skip any block scopes and only process global scope.
-    if(isSgBasicBlock(n)) {
-        sync = n;
-        return;
-    }
+    if(isSgBasicBlock(n))
+        return false;
     
     if(isSgVariableDeclaration(n)) {
         #if DEBUG
@@ -1605,8 +4032,7 @@ void ftc::GenVisitor::preOrderVisit(SgNode* n) {
             attachArbitraryText(var_decl, "extern",PreprocessingInfo::before);
         }
         
-        sync = n;
-        return;
+        return false;
     }
     
     if(isSgFunctionDeclaration(n)) {
@@ -1632,13 +4058,10 @@ void ftc::GenVisitor::preOrderVisit(SgNode* n) {
         appendStatement(fn_decl);
         attachArbitraryText(fn_decl,";",PreprocessingInfo::after);
         
-        sync = n;
-        return;
+        return false;
     }
-}
-
-void ftc::GenVisitor::postOrderVisit(SgNode* n) {
-    if(n==sync) sync = NULL;
+    
+    return true;
 }
 
 ///_________________________________________________________________________________________________
@@ -1698,3 +4121,28 @@ SgFile* ftc::xf_gen_header(SgFile* file, SgProject* project) {
     return outf;
 }
 
+
+///_________________________________________________________________________________________________
+///
+
+namespace ftc {
+    //ArrDimAttributes are owned by the translator, not the AST.
+    class AttributeReleaser : public PruningTraversal {
+    protected:
+        bool preOrderVisit(SgNode* n) {
+            if(isSgInitializedName(n) && n->attributeExists("dim")) {
+                auto* dimattr = static_cast<ArrDimAttribute*>(n->getAttribute("dim"));
+                n->removeAttribute("dim");
+                delete dimattr;
+            }
+            return true;
+        }
+    };
+}
+
+void ftc::xf_release_attributes(SgFile* file) {
+    assert(file!=NULL);
+    
+    AttributeReleaser releaser;
+    releaser.traverse(file);
+}
@@ -0,0 +1,21 @@
+integer(4) function main(argc, argv)
+
+    integer(4) :: argc
+    character(len=*), dimension(*) :: argv
+
+    ! double precision keeps its kind through **: ftc__powi and pow, not the float versions.
+    double precision :: x, y
+    real(4) :: s
+    integer(4) :: k
+
+    x = 1.1d0
+    y = 0.5d0
+    s = 2.0
+    k = 7
+
+    print *, x**k, x**(-k), x**y
+    print *, 1/(2*x**0), s**0, 2**30, 46341**1
+
+    main = 0
+    return
+end
@@ -0,0 +1,26 @@
+integer(4) function main(argc, argv)
+
+    integer(4) :: argc
+    character(len=*), dimension(*) :: argv
+
+    real(8), dimension(4) :: x
+    integer(4), dimension(3) :: a
+    integer(4) :: i
+
+    do i = 1,4
+       x(i) = i
+    enddo
+    a(1) = 3
+    a(2) = 5
+    a(3) = 7
+
+    ! the right hand side is evaluated before any of x is assigned: sum(x) once, over the
+    ! original values, and a(1) before a(1) is overwritten.
+    x = x/sum(x)
+    a = a(1)*2
+    print *, x(1), x(4), sum(x)
+    print *, a(1), a(2), a(3)
+
+    main = 0
+    return
+end
@@ -1,15 +0,0 @@
-#include <stdio.h> 
-#include <math.h> 
-#include <routines.h> 
-#include <main.h> 
-
-int main()
-{
-  int __retv;
-  double x;
-  int y;
-  set_x(&x,y);
-  printf("%s%lf\n","x is: ",x);
-  __retv = 0;
-  return __retv;
-}
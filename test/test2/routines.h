@@ -1,5 +0,0 @@
-#pragma once
-double add(double x,int y)
-;
-void set_x(double *x,int y)
-;
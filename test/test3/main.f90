@@ -4,12 +4,14 @@ integer(4) function main(argc, argv)
     character(len=*), dimension(*) :: argv
 
     integer(4) :: value
+    real(8) :: x, y
 
     OPEN(3,file=argv(2))
-    READ (3,*) value
+    READ (3,*) value, x, y
     CLOSE(3)       
 
     print *, "value=",value
+    print *, x, y
 
     main = 0
     return
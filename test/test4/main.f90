@@ -0,0 +1,40 @@
+integer(4) function main(argc, argv)
+
+    integer(4) :: argc
+    character(len=*), dimension(*) :: argv
+
+    real(8), dimension(8) :: a, b, c
+    integer(4), dimension(0:4,3) :: m
+    integer(4) :: i, n
+
+    n = 8
+    do i = 1,n
+       b(i) = i
+       c(i) = 2*i
+    enddo
+
+    ! whole arrays, fused into one loop.
+    a = b + c*2.0
+    print *, a(1), a(8)
+
+    ! overlapping sections of the same array go through a temporary.
+    a(1:n-1) = a(2:n)
+    print *, a(1), a(7)
+
+    ! scalar broadcast, strided section.
+    a(2:n:2) = 0.0
+    print *, a(1), a(2), a(8)
+
+    ! element for element update of the same array needs no temporary.
+    a = a + abs(b - c)
+    print *, a(1), a(8)
+
+    ! sections of a rank 2 array.
+    m = 1
+    m(2,:) = 7
+    m(:,3) = m(:,1) + m(:,2)
+    print *, m(0,1), m(2,2), m(2,3), m(4,3)
+
+    main = 0
+    return
+end
@@ -0,0 +1,39 @@
+integer(4) function main(argc, argv)
+
+    integer(4) :: argc
+    character(len=*), dimension(*) :: argv
+
+    real(8), dimension(100) :: x, y
+    real(8), dimension(3,2) :: a
+    real(8), dimension(2,4) :: b
+    real(8), dimension(3,4) :: c
+    integer(4), dimension(5) :: k
+    integer(4) :: i, j
+
+    do i = 1,100
+       x(i) = i
+       y(i) = 2
+    enddo
+    do j = 1,2
+       do i = 1,3
+          a(i,j) = i + 10*j
+       enddo
+    enddo
+    b = 1.0
+    do i = 1,5
+       k(i) = i
+    enddo
+
+    ! contiguous arguments call into libftc.
+    print *, sum(x), maxval(x), minval(x(10:20)), dot_product(x, y)
+    print *, product(k), sum(a(:,2))
+
+    ! anything else is reduced in place.
+    print *, sum(x(1:100:2)), maxval(x*y - 150.0), sum(a(2,:))
+
+    c = matmul(a, b)
+    print *, c(1,1), c(3,4)
+
+    main = 0
+    return
+end
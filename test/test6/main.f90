@@ -0,0 +1,33 @@
+integer(4) function main(argc, argv)
+
+    integer(4) :: argc
+    character(len=*), dimension(*) :: argv
+
+    real(8), allocatable, dimension(:) :: u
+    real(8), allocatable, dimension(:,:) :: w
+    integer(4) :: i, j, step, n
+
+    n = 16
+
+    ! work arrays allocated and freed every step reuse the same memory.
+    do step = 1,10
+       allocate(u(n), w(0:n-1,3))
+       do j = 1,3
+          do i = 0,n-1
+             w(i,j) = i*j
+          enddo
+       enddo
+       u = w(:,2) + step
+       deallocate(u, w)
+    enddo
+
+    print *, allocated(u)
+
+    allocate(u(-2:2))
+    u = 1.0
+    u(0) = 5.0
+    print *, u(-2), u(0), sum(u)
+
+    main = 0
+    return
+end
@@ -0,0 +1,31 @@
+integer(4) function main(argc, argv)
+
+    integer(4) :: argc
+    character(len=*), dimension(*) :: argv
+
+    ! sizes and bounds in terms of PARAMETERs fold to constants: fixed size arrays, no VLAs.
+    integer(4), parameter :: n = 1024
+    integer(4), parameter :: half = n/2
+    integer(4), parameter :: dp = 8
+    real(dp), parameter :: h = 1.0d0/n
+
+    real(dp), dimension(0:n-1) :: x
+    integer(4), dimension(half, 2) :: m
+    integer(4) :: i, j
+
+    do i = 0, n-1
+       x(i) = i*h
+    enddo
+    print *, x(0), x(n-1)
+
+    ! a constant step, so a plain for loop.
+    do j = 1, 2
+       do i = half, 1, -half/4
+          m(i,j) = i*j + 2**3
+       enddo
+    enddo
+    print *, m(half,1), m(half/4,2)
+
+    main = 0
+    return
+end
@@ -0,0 +1,35 @@
+integer(4) function main(argc, argv)
+
+    integer(4) :: argc
+    character(len=*), dimension(*) :: argv
+
+    real(8), dimension(100,50) :: u, v
+    integer(4) :: i, j, n
+
+    do j = 1,50
+       do i = 1,100
+          u(i,j) = i + 1000*j
+       enddo
+    enddo
+    n = 50
+
+    ! each array is one bulk transfer; records are laid out as gfortran's.
+    open(7, file=argv(2), form='unformatted', status='replace')
+    write(7) n, u
+    write(7) u(:,n)
+    close(7)
+
+    open(7, file=argv(2), form='unformatted', status='old', action='read')
+    read(7) n, v
+    read(7) v(:,1)
+    close(7)
+    print *, n, v(100,50), v(1,1)
+
+    ! stream access: no record markers.
+    open(8, file=argv(2), access='stream', status='replace')
+    write(8) u
+    close(8)
+
+    main = 0
+    return
+end
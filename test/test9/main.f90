@@ -0,0 +1,38 @@
+integer(4) function main(argc, argv)
+
+    integer(4) :: argc
+    character(len=*), dimension(*) :: argv
+
+    real(8), dimension(10,20) :: a, b
+    integer(4), dimension(20) :: k
+    integer(4) :: i, j, n
+
+    do j = 1,20
+       do i = 1,10
+          a(i,j) = i + 100*j
+       enddo
+       k(j) = j
+    enddo
+    n = 20
+
+    ! a column, a row (stride 10) and every other element of k: one vector call each.
+    open(7, file='values.txt', status='replace')
+    write(7,*) n, (a(i,3), i=1,10)
+    write(7,*) (a(4,j), j=1,n)
+    write(7,*) (k(j), j=n,1,-2)
+    write(7,*) k
+    close(7)
+
+    open(7, file='values.txt', status='old', action='read')
+    read(7,*) n, (b(i,3), i=1,10)
+    read(7,*) (b(4,j), j=1,n)
+    read(7,*) (k(j+1), j=0,9)
+    close(7)
+    print *, n, b(10,3), b(4,20), k(1), k(10)
+
+    ! the do variables are left as the loops would have left them.
+    print *, i, j
+
+    main = 0
+    return
+end